@@ -0,0 +1,162 @@
+// Compile-time benchmark harness: times the lex-only, parse-only and full
+// pipelines over a corpus file with warmup, and reports tokens/sec,
+// nodes/sec and peak RSS. Links the compiler sources directly so each
+// phase can be driven in isolation.
+//
+// Usage: ccl-bench <file.c> [iterations]
+
+#include "codegen.hpp"
+#include "fold.hpp"
+#include "interner.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "source_buffer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+long peakRssKiB() {
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) == 0) return ru.ru_maxrss;
+#endif
+  return 0;
+}
+
+std::size_t countNodes(const TranslationUnit &tu) {
+  // Statements and expressions, walked with explicit stacks.
+  std::size_t n = 0;
+  std::vector<const Stmt *> stmts;
+  std::vector<const Expr *> exprs;
+  for (const Function *fn : tu.functions)
+    stmts.insert(stmts.end(), fn->body.begin(), fn->body.end());
+  while (!stmts.empty() || !exprs.empty()) {
+    if (!exprs.empty()) {
+      const Expr *e = exprs.back(); exprs.pop_back();
+      ++n;
+      switch (e->kind) {
+      case ExprKind::Binary:
+        exprs.push_back(static_cast<const BinaryExpr *>(e)->lhs);
+        exprs.push_back(static_cast<const BinaryExpr *>(e)->rhs);
+        break;
+      case ExprKind::Unary: exprs.push_back(static_cast<const UnaryExpr *>(e)->operand); break;
+      case ExprKind::Assign: exprs.push_back(static_cast<const AssignExpr *>(e)->value); break;
+      case ExprKind::Call:
+        for (const Expr *a : static_cast<const CallExpr *>(e)->args) exprs.push_back(a);
+        break;
+      case ExprKind::Number:
+      case ExprKind::Variable:
+        break;
+      }
+      continue;
+    }
+    const Stmt *s = stmts.back(); stmts.pop_back();
+    ++n;
+    switch (s->kind) {
+    case StmtKind::Return: exprs.push_back(static_cast<const ReturnStmt *>(s)->value); break;
+    case StmtKind::Expr: exprs.push_back(static_cast<const ExprStmt *>(s)->expr); break;
+    case StmtKind::VarDecl:
+      if (auto *init = static_cast<const VarDeclStmt *>(s)->init) exprs.push_back(init);
+      break;
+    case StmtKind::If: {
+      auto *ifs = static_cast<const IfStmt *>(s);
+      exprs.push_back(ifs->cond);
+      stmts.insert(stmts.end(), ifs->thenStmts.begin(), ifs->thenStmts.end());
+      stmts.insert(stmts.end(), ifs->elseStmts.begin(), ifs->elseStmts.end());
+      break;
+    }
+    case StmtKind::While: {
+      auto *ws = static_cast<const WhileStmt *>(s);
+      exprs.push_back(ws->cond);
+      stmts.insert(stmts.end(), ws->body.begin(), ws->body.end());
+      break;
+    }
+    }
+  }
+  return n;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: ccl-bench <file.c> [iterations]\n");
+    return 1;
+  }
+  const std::string path = argv[1];
+  long iters = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 5;
+  if (iters < 1) iters = 1;
+
+  try {
+    SourceBuffer source = SourceBuffer::open(path);
+
+    // Warmup: one untimed full pipeline to fault pages in and warm the
+    // allocator before any measurement.
+    {
+      Interner interner;
+      Lexer lex(source.view(), interner);
+      Parser parser(lex);
+      auto tu = parser.parseTranslationUnit();
+      (void)CodeGen("bench", interner).emitIR(*tu);
+    }
+
+    std::size_t tokenCount = 0;
+    auto lexStart = Clock::now();
+    for (long i = 0; i < iters; ++i) {
+      Interner interner;
+      Lexer lex(source.view(), interner);
+      tokenCount = lex.lexAll().size();
+    }
+    double lexSec = secondsSince(lexStart) / iters;
+
+    std::size_t nodeCount = 0;
+    auto parseStart = Clock::now();
+    for (long i = 0; i < iters; ++i) {
+      Interner interner;
+      Lexer lex(source.view(), interner);
+      Parser parser(lex);
+      auto tu = parser.parseTranslationUnit();
+      nodeCount = countNodes(*tu);
+    }
+    double parseSec = secondsSince(parseStart) / iters;
+
+    auto fullStart = Clock::now();
+    for (long i = 0; i < iters; ++i) {
+      Interner interner;
+      Lexer lex(source.view(), interner);
+      Parser parser(lex);
+      auto tu = parser.parseTranslationUnit();
+      foldTranslationUnit(*tu);
+      (void)CodeGen("bench", interner).emitIR(*tu);
+    }
+    double fullSec = secondsSince(fullStart) / iters;
+
+    std::printf("file: %s (%zu bytes, %ld iterations)\n", path.c_str(), source.view().size(), iters);
+    std::printf("lex:   %8.3f ms  %12.0f tokens/sec  (%zu tokens)\n",
+                lexSec * 1e3, tokenCount / lexSec, tokenCount);
+    std::printf("parse: %8.3f ms  %12.0f nodes/sec   (%zu nodes)\n",
+                parseSec * 1e3, nodeCount / parseSec, nodeCount);
+    std::printf("full:  %8.3f ms  %12.0f nodes/sec\n", fullSec * 1e3, nodeCount / fullSec);
+    std::printf("peak rss: %ld KiB\n", peakRssKiB());
+  } catch (const std::exception &ex) {
+    std::fprintf(stderr, "error: %s\n", ex.what());
+    return 1;
+  }
+
+  return 0;
+}
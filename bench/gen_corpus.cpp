@@ -0,0 +1,65 @@
+// Synthetic workload generator for the ccl benchmark suite. Each mode
+// stresses one phase:
+//
+//   expr    deep/wide constant-free expressions (parser recursion, codegen)
+//   funcs   thousands of small functions (declaration tables, emitIR loop)
+//   idents  identifier-dense straight-line code (lexer hot path)
+//
+// Usage: ccl-gen-corpus <expr|funcs|idents> <size> [out.c]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::fprintf(stderr, "usage: ccl-gen-corpus <expr|funcs|idents> <size> [out.c]\n");
+    return 1;
+  }
+  const char *mode = argv[1];
+  long size = std::strtol(argv[2], nullptr, 10);
+  if (size < 1) { std::fprintf(stderr, "error: invalid size\n"); return 1; }
+
+  std::FILE *out = stdout;
+  if (argc > 3) {
+    out = std::fopen(argv[3], "w");
+    if (!out) { std::fprintf(stderr, "error: could not open %s\n", argv[3]); return 1; }
+  }
+
+  if (std::strcmp(mode, "expr") == 0) {
+    // `size` binary operators total, in statements of 50 so the depth per
+    // expression stays bounded. Operators alternate and reference the
+    // parameter so the folder can't collapse anything.
+    std::fprintf(out, "int work(int a) {\n  int r = a;\n");
+    for (long i = 0; i < size; i += 50) {
+      std::fprintf(out, "  r = r");
+      long ops = size - i < 50 ? size - i : 50;
+      for (long j = 0; j < ops; ++j)
+        std::fprintf(out, " %c (a %c %ld)", "+-*"[(i + j) % 3], "+*"[(i + j) % 2], (i + j) % 97 + 1);
+      std::fprintf(out, ";\n");
+    }
+    std::fprintf(out, "  return r;\n}\nint main() { return work(3); }\n");
+  } else if (std::strcmp(mode, "funcs") == 0) {
+    // `size` small functions calling their predecessor.
+    std::fprintf(out, "int f0(int a) { return a + 1; }\n");
+    for (long i = 1; i < size; ++i)
+      std::fprintf(out, "int f%ld(int a) { int b = a * %ld; return f%ld(b) + %ld; }\n",
+                   i, i % 89 + 1, i - 1, i % 13);
+    std::fprintf(out, "int main() { return f%ld(1); }\n", size - 1);
+  } else if (std::strcmp(mode, "idents") == 0) {
+    // Long runs of declarations and assignments with chunky identifiers.
+    std::fprintf(out, "int main() {\n");
+    std::fprintf(out, "  int accumulator_value_0 = 0;\n");
+    for (long i = 1; i < size; ++i)
+      std::fprintf(out, "  int accumulator_value_%ld = accumulator_value_%ld + %ld;\n",
+                   i, i - 1, i % 31);
+    std::fprintf(out, "  return accumulator_value_%ld;\n}\n", size - 1);
+  } else {
+    std::fprintf(stderr, "error: unknown mode: %s\n", mode);
+    return 1;
+  }
+
+  if (out != stdout) std::fclose(out);
+  return 0;
+}
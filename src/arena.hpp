@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator that owns every AST node of a TranslationUnit. Nodes are
+// handed out as raw pointers; the whole tree is released in a handful of
+// free() calls when the arena dies instead of a recursive unique_ptr chain.
+//
+// Nodes with non-trivial members (std::string, std::vector) are registered
+// for a flat, linear destructor sweep so nothing leaks; trivially
+// destructible nodes pay no bookkeeping at all.
+class Arena {
+public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  ~Arena() {
+    // Linear sweep, newest first, then drop all blocks at once.
+    for (auto it = dtors.rbegin(); it != dtors.rend(); ++it) it->destroy(it->object);
+    for (const Block &block : blocks) std::free(block.memory);
+  }
+
+  // Destroy the current contents but keep the memory: a long-lived process
+  // compiling file after file reaches steady state with zero mallocs here.
+  // Multiple blocks coalesce into one of their combined size on the next
+  // reset, so fragmentation from a big first file self-heals.
+  void reset() {
+    for (auto it = dtors.rbegin(); it != dtors.rend(); ++it) it->destroy(it->object);
+    dtors.clear();
+    if (blocks.size() > 1) {
+      std::size_t total = 0;
+      for (const Block &block : blocks) total += block.size;
+      for (const Block &block : blocks) std::free(block.memory);
+      blocks.clear();
+      capacity = 0; // keep state consistent if the malloc below throws
+      void *merged = std::malloc(total);
+      if (!merged) throw std::bad_alloc();
+      blocks.push_back(Block{merged, total});
+      capacity = total;
+    }
+    cursor = 0;
+  }
+
+  template <typename T, typename... Args>
+  T *create(Args &&...args) {
+    void *mem = allocate(sizeof(T), alignof(T));
+    T *obj = new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      dtors.push_back(DtorRecord{obj, [](void *p) { static_cast<T *>(p)->~T(); }});
+    }
+    return obj;
+  }
+
+  void *allocate(std::size_t size, std::size_t align) {
+    std::size_t offset = (cursor + align - 1) & ~(align - 1);
+    if (offset + size > capacity) {
+      grow(size + align);
+      offset = (cursor + align - 1) & ~(align - 1);
+    }
+    cursor = offset + size;
+    return static_cast<char *>(blocks.back().memory) + offset;
+  }
+
+private:
+  struct DtorRecord {
+    void *object;
+    void (*destroy)(void *);
+  };
+
+  struct Block {
+    void *memory;
+    std::size_t size;
+  };
+
+  static constexpr std::size_t kBlockSize = 1u << 16;
+
+  std::vector<Block> blocks;
+  std::vector<DtorRecord> dtors;
+  std::size_t cursor{0};
+  std::size_t capacity{0};
+
+  void grow(std::size_t atLeast) {
+    std::size_t size = atLeast > kBlockSize ? atLeast : kBlockSize;
+    void *block = std::malloc(size);
+    if (!block) throw std::bad_alloc();
+    blocks.push_back(Block{block, size});
+    cursor = 0;
+    capacity = size;
+  }
+};
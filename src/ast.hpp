@@ -1,7 +1,12 @@
 #pragma once
 
+#include "arena.hpp"
+#include "interner.hpp"
+
+#include <llvm/ADT/SmallVector.h>
+
 #include <memory>
-#include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -10,99 +15,165 @@ struct Stmt;
 struct Function;
 struct TranslationUnit;
 
-using ExprPtr = std::unique_ptr<Expr>;
-using StmtPtr = std::unique_ptr<Stmt>;
-using FuncPtr = std::unique_ptr<Function>;
+// Nodes live in the owning TranslationUnit's arena; these are non-owning.
+using ExprPtr = Expr *;
+using StmtPtr = Stmt *;
 using TUPtr = std::unique_ptr<TranslationUnit>;
 
+struct FunctionParam;
+
+// Small-size-optimized lists: statement bodies, call argument lists and
+// parameter lists run 1-3 entries in real inputs, so the common case stays
+// inline in the node with no separate heap block to chase.
+using StmtList = llvm::SmallVector<StmtPtr, 4>;
+using ExprList = llvm::SmallVector<ExprPtr, 4>;
+using ParamList = llvm::SmallVector<FunctionParam, 4>;
+
+// Node-kind discriminators: set once at construction, dispatched on with a
+// switch instead of dynamic_cast chains (RTTI lookups were a double-digit
+// share of codegen time on expression-heavy inputs).
+enum class ExprKind : unsigned char {
+  Number,
+  Variable,
+  Binary,
+  Call,
+  Unary,
+  Assign,
+};
+
+// Binary/unary operators as compact enums carried from TokenKind straight
+// through the AST: codegen dispatches with a jump table instead of up to
+// thirteen string comparisons per node.
+enum class BinOp : unsigned char {
+  Add,
+  Sub,
+  Mul,
+  Div,
+  Rem,
+  Eq,
+  Ne,
+  Lt,
+  Le,
+  Gt,
+  Ge,
+  LogicalAnd,
+  LogicalOr,
+  BitAnd,
+  BitOr,
+  BitXor,
+  Shl,
+  Shr,
+};
+
+enum class UnOp : unsigned char {
+  Neg,
+  Plus,
+  Not,
+};
+
+enum class StmtKind : unsigned char {
+  Return,
+  Expr,
+  VarDecl,
+  If,
+  While,
+};
+
+// No virtual destructor: nodes are never deleted through a base pointer --
+// the arena registers each node's concrete destructor at creation.
 struct Expr {
-  virtual ~Expr() = default;
+  ExprKind kind;
+  explicit Expr(ExprKind k) : kind(k) {}
 };
 
 struct NumberExpr : Expr {
   long long value;
-  explicit NumberExpr(long long v) : value(v) {}
+  explicit NumberExpr(long long v) : Expr(ExprKind::Number), value(v) {}
 };
 
 struct VariableExpr : Expr {
-  std::string name;
-  explicit VariableExpr(std::string n) : name(std::move(n)) {}
+  Symbol name;
+  explicit VariableExpr(Symbol n) : Expr(ExprKind::Variable), name(n) {}
 };
 
 struct BinaryExpr : Expr {
-  std::string op;
+  BinOp op;
   ExprPtr lhs;
   ExprPtr rhs;
-  BinaryExpr(std::string op, ExprPtr lhs, ExprPtr rhs)
-      : op(std::move(op)), lhs(std::move(lhs)), rhs(std::move(rhs)) {}
+  BinaryExpr(BinOp op, ExprPtr lhs, ExprPtr rhs)
+      : Expr(ExprKind::Binary), op(op), lhs(lhs), rhs(rhs) {}
 };
 
 struct CallExpr : Expr {
-  std::string callee;
-  std::vector<ExprPtr> args;
-  CallExpr(std::string c, std::vector<ExprPtr> a)
-      : callee(std::move(c)), args(std::move(a)) {}
+  Symbol callee;
+  ExprList args;
+  CallExpr(Symbol c, ExprList a)
+      : Expr(ExprKind::Call), callee(c), args(std::move(a)) {}
 };
 
 struct UnaryExpr : Expr {
-  std::string op;
+  UnOp op;
   ExprPtr operand;
-  UnaryExpr(std::string o, ExprPtr e) : op(std::move(o)), operand(std::move(e)) {}
+  UnaryExpr(UnOp o, ExprPtr e) : Expr(ExprKind::Unary), op(o), operand(e) {}
 };
 
 struct AssignExpr : Expr {
-  std::string name;
+  Symbol name;
   ExprPtr value;
-  AssignExpr(std::string n, ExprPtr v) : name(std::move(n)), value(std::move(v)) {}
+  AssignExpr(Symbol n, ExprPtr v) : Expr(ExprKind::Assign), name(n), value(v) {}
 };
 
 struct Stmt {
-  virtual ~Stmt() = default;
+  StmtKind kind;
+  explicit Stmt(StmtKind k) : kind(k) {}
 };
 
 struct ReturnStmt : Stmt {
   ExprPtr value;
-  explicit ReturnStmt(ExprPtr v) : value(std::move(v)) {}
+  explicit ReturnStmt(ExprPtr v) : Stmt(StmtKind::Return), value(v) {}
 };
 
 struct ExprStmt : Stmt {
   ExprPtr expr;
-  explicit ExprStmt(ExprPtr e) : expr(std::move(e)) {}
+  explicit ExprStmt(ExprPtr e) : Stmt(StmtKind::Expr), expr(e) {}
 };
 
 struct VarDeclStmt : Stmt {
-  std::string name;
+  Symbol name;
   ExprPtr init; // optional
-  VarDeclStmt(std::string n, ExprPtr i) : name(std::move(n)), init(std::move(i)) {}
+  VarDeclStmt(Symbol n, ExprPtr i) : Stmt(StmtKind::VarDecl), name(n), init(i) {}
 };
 
 struct IfStmt : Stmt {
+  IfStmt() : Stmt(StmtKind::If) {}
   ExprPtr cond;
-  std::vector<StmtPtr> thenStmts;
-  std::vector<StmtPtr> elseStmts; // may be empty
+  StmtList thenStmts;
+  StmtList elseStmts; // may be empty
 };
 
 struct WhileStmt : Stmt {
+  WhileStmt() : Stmt(StmtKind::While) {}
   ExprPtr cond;
-  std::vector<StmtPtr> body;
+  StmtList body;
 };
 
 struct FunctionParam {
-  std::string name;
+  Symbol name;
 };
 
 struct Function {
-  std::string name;
-  std::vector<FunctionParam> params;
-  std::vector<StmtPtr> body;
+  Symbol name;
+  ParamList params;
+  StmtList body;
 };
 
 struct ExternDecl {
-  std::string name;
-  std::vector<FunctionParam> params;
+  Symbol name;
+  ParamList params;
 };
 
 struct TranslationUnit {
-  std::vector<std::unique_ptr<ExternDecl>> externs;
-  std::vector<FuncPtr> functions;
+  Arena arena; // owns every node reachable from the lists below
+  std::vector<ExternDecl *> externs;
+  std::vector<Function *> functions;
 };
@@ -0,0 +1,54 @@
+#include "cache.hpp"
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/SHA1.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+CompileCache::CompileCache(std::string dir) : dir(std::move(dir)) {
+  if (mkdir(this->dir.c_str(), 0755) != 0 && errno != EEXIST)
+    throw std::runtime_error("could not create cache directory: " + this->dir);
+}
+
+std::string CompileCache::key(std::string_view source, const std::string &fingerprint) {
+  llvm::SHA1 sha;
+  sha.update(llvm::StringRef(fingerprint.data(), fingerprint.size()));
+  sha.update(llvm::StringRef("\0", 1)); // keep "ab"+"c" distinct from "a"+"bc"
+  sha.update(llvm::StringRef(source.data(), source.size()));
+  return llvm::toHex(sha.final(), /*LowerCase=*/true);
+}
+
+std::string CompileCache::entryPath(const std::string &key) const { return dir + "/" + key; }
+
+bool CompileCache::load(const std::string &key, std::string &out) const {
+  std::ifstream in(entryPath(key), std::ios::binary);
+  if (!in) return false;
+  std::stringstream ss;
+  ss << in.rdbuf();
+  out = ss.str();
+  return static_cast<bool>(in);
+}
+
+void CompileCache::store(const std::string &key, std::string_view bytes) const {
+  std::string finalPath = entryPath(key);
+  std::string tmpPath = finalPath + ".tmp." + std::to_string(::getpid());
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out) return; // cache is best effort; the compile already succeeded
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    out.flush();
+    if (!out) {
+      std::remove(tmpPath.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmpPath.c_str(), finalPath.c_str()) != 0) std::remove(tmpPath.c_str());
+}
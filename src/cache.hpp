@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Content-addressed compilation cache: keyed by a SHA-1 of the input bytes
+// plus a fingerprint of everything else that shapes the output (ccl
+// version, emission kind, flags) -- 160 bits, because a key collision
+// silently replays the wrong artifact and the farm feeds this hundreds of
+// thousands of near-identical generated files. On a hit the stored output
+// is replayed and the whole Lexer/Parser/CodeGen pipeline is skipped; on a
+// miss the fresh output is stored with an atomic write. One file per entry
+// in a flat cache directory, named by the hex digest.
+class CompileCache {
+public:
+  // Creates the directory if needed; throws std::runtime_error on failure.
+  explicit CompileCache(std::string dir);
+
+  // Hex SHA-1 digest of fingerprint + source.
+  static std::string key(std::string_view source, const std::string &fingerprint);
+
+  // Reads the entry into `out`; false if absent.
+  bool load(const std::string &key, std::string &out) const;
+
+  // Write-to-temp plus rename, so concurrent compilers never observe a
+  // partial entry.
+  void store(const std::string &key, std::string_view bytes) const;
+
+private:
+  std::string dir;
+
+  std::string entryPath(const std::string &key) const;
+};
@@ -10,12 +10,49 @@
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Verifier.h>
 
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <map>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace llvm;
 
-CodeGen::CodeGen(const std::string &moduleName) {
+// Token/AST strings are std::string_view slices of the source buffer; LLVM
+// wants StringRef. Same bytes, no copy.
+static StringRef toRef(std::string_view s) { return StringRef(s.data(), s.size()); }
+
+// Target registration splices an unsynchronized global list; two threads
+// racing past its already-registered guard can corrupt the registry (the
+// TargetRegistry docs forbid registering concurrently with access). Both
+// emitObject and runJIT are reachable from concurrent workers (--jobs with
+// -c, one CompileSession per thread), so registration is serialized here
+// and still lazy enough that IR-only paths never pay for it.
+static void initializeNativeTargetOnce() {
+  static std::once_flag once;
+  std::call_once(once, [] {
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+  });
+}
+
+CodeGen::CodeGen(const std::string &moduleName, const Interner &interner, unsigned optLevel,
+                 CompileStats *stats, bool shortCircuit, bool emitAll, VerifyMode verify)
+    : interner(interner), optLevel(optLevel), stats(stats ? stats : &CompileStats::discard()),
+      shortCircuit(shortCircuit), emitAll(emitAll), verifyMode(verify) {
   context = std::make_unique<LLVMContext>();
   module = std::make_unique<Module>(moduleName, *context);
   builder = std::make_unique<IRBuilder<>>(*context);
@@ -23,119 +60,240 @@ CodeGen::CodeGen(const std::string &moduleName) {
 
 Type *CodeGen::getIntType() { return Type::getInt32Ty(*context); }
 
-llvm::Function *CodeGen::getFunction(const std::string &name) {
-  if (auto *f = module->getFunction(name)) return f;
+llvm::Function *CodeGen::getFunction(Symbol name) {
+  if (auto *f = module->getFunction(toRef(interner.spelling(name)))) return f;
   return nullptr;
 }
 
 llvm::Function *CodeGen::declareExtern(const ExternDecl &decl) {
   std::vector<Type*> paramTys(decl.params.size(), getIntType());
   FunctionType *ft = FunctionType::get(getIntType(), paramTys, false);
-  llvm::Function *f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, decl.name, module.get());
+  llvm::Function *f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, toRef(interner.spelling(decl.name)), module.get());
   unsigned idx = 0;
-  for (auto &arg : f->args()) { arg.setName(decl.params[idx++].name); }
+  for (auto &arg : f->args()) { arg.setName(toRef(interner.spelling(decl.params[idx++].name))); }
   return f;
 }
 
 llvm::Function *CodeGen::declareFunction(const ::Function &fn) {
   std::vector<Type*> paramTys(fn.params.size(), getIntType());
   FunctionType *ft = FunctionType::get(getIntType(), paramTys, false);
-  llvm::Function *f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, fn.name, module.get());
+  llvm::Function *f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, toRef(interner.spelling(fn.name)), module.get());
   unsigned idx = 0;
-  for (auto &arg : f->args()) { arg.setName(fn.params[idx++].name); }
+  for (auto &arg : f->args()) { arg.setName(toRef(interner.spelling(fn.params[idx++].name))); }
   return f;
 }
 
-static AllocaInst *createEntryBlockAlloca(llvm::Function *f, const std::string &name, Type *ty, IRBuilder<> &builder) {
+static AllocaInst *createEntryBlockAlloca(llvm::Function *f, StringRef name, Type *ty, IRBuilder<> &builder) {
   IRBuilder<> tmp(&f->getEntryBlock(), f->getEntryBlock().begin());
   return tmp.CreateAlloca(ty, nullptr, name);
 }
 
+// Worklist expression codegen: a Frame per in-flight node, resumed as its
+// operands land on the value stack. O(1) call stack regardless of tree
+// depth, and the call/return overhead of one frame per operator is gone.
+// Short-circuit && / || is a three-state frame: evaluate lhs, branch and
+// evaluate rhs in its own block, merge with a phi -- the same blocks the
+// old recursive codegenShortCircuit built.
 Value *CodeGen::codegenExpr(const Expr &expr) {
-  if (auto *n = dynamic_cast<const NumberExpr*>(&expr)) {
-    return ConstantInt::get(getIntType(), n->value, true);
-  }
-  if (auto *v = dynamic_cast<const VariableExpr*>(&expr)) {
-    auto it = namedAllocas.find(v->name);
-    if (it == namedAllocas.end()) throw std::runtime_error("Unknown variable: " + v->name);
-    return builder->CreateLoad(getIntType(), it->second, v->name.c_str());
-  }
-  if (auto *b = dynamic_cast<const BinaryExpr*>(&expr)) {
-    return codegenBinary(*b);
-  }
-  if (auto *u = dynamic_cast<const UnaryExpr*>(&expr)) {
-    return codegenUnary(*u);
-  }
-  if (auto *c = dynamic_cast<const CallExpr*>(&expr)) {
-    return codegenCall(*c);
-  }
-  if (auto *a = dynamic_cast<const AssignExpr*>(&expr)) {
-    return codegenAssign(*a);
-  }
-  throw std::runtime_error("Unhandled expression");
-}
-
-Value *CodeGen::codegenBinary(const BinaryExpr &bin) {
-  Value *L = codegenExpr(*bin.lhs);
-  Value *R = codegenExpr(*bin.rhs);
-  if (bin.op == "+") return builder->CreateAdd(L, R, "addtmp");
-  if (bin.op == "-") return builder->CreateSub(L, R, "subtmp");
-  if (bin.op == "*") return builder->CreateMul(L, R, "multmp");
-  if (bin.op == "/") return builder->CreateSDiv(L, R, "divtmp");
-  if (bin.op == "%") return builder->CreateSRem(L, R, "remtmp");
-  if (bin.op == "==") return builder->CreateZExt(builder->CreateICmpEQ(L, R), getIntType(), "eqtmp");
-  if (bin.op == "!=") return builder->CreateZExt(builder->CreateICmpNE(L, R), getIntType(), "netmp");
-  if (bin.op == "<") return builder->CreateZExt(builder->CreateICmpSLT(L, R), getIntType(), "lttmp");
-  if (bin.op == "<=") return builder->CreateZExt(builder->CreateICmpSLE(L, R), getIntType(), "letmp");
-  if (bin.op == ">") return builder->CreateZExt(builder->CreateICmpSGT(L, R), getIntType(), "gttmp");
-  if (bin.op == ">=") return builder->CreateZExt(builder->CreateICmpSGE(L, R), getIntType(), "getmp");
-  if (bin.op == "&&") {
-    // simple non-short-circuit: (L != 0) & (R != 0)
+  struct Frame {
+    const Expr *e;
+    unsigned state{0};
+    Value *scratch{nullptr};         // short-circuit: lhs i1
+    BasicBlock *lhsEnd{nullptr};     // short-circuit blocks
+    BasicBlock *mergeBB{nullptr};
+  };
+
+  std::vector<Frame> frames;
+  std::vector<Value *> values;
+  frames.push_back(Frame{&expr});
+
+  while (!frames.empty()) {
+    Frame &f = frames.back();
+    switch (f.e->kind) {
+    case ExprKind::Number:
+      values.push_back(ConstantInt::get(getIntType(), static_cast<const NumberExpr &>(*f.e).value, true));
+      frames.pop_back();
+      break;
+    case ExprKind::Variable: {
+      auto &v = static_cast<const VariableExpr &>(*f.e);
+      AllocaInst *alloca = lookupAlloca(v.name);
+      if (!alloca)
+        throw std::runtime_error("Unknown variable: " + std::string(interner.spelling(v.name)));
+      values.push_back(builder->CreateLoad(getIntType(), alloca, toRef(interner.spelling(v.name))));
+      frames.pop_back();
+      break;
+    }
+    case ExprKind::Unary: {
+      auto &un = static_cast<const UnaryExpr &>(*f.e);
+      if (f.state == 0) {
+        f.state = 1;
+        frames.push_back(Frame{un.operand});
+      } else {
+        Value *v = values.back();
+        values.pop_back();
+        values.push_back(emitUnary(un, v));
+        frames.pop_back();
+      }
+      break;
+    }
+    case ExprKind::Assign: {
+      auto &as = static_cast<const AssignExpr &>(*f.e);
+      if (f.state == 0) {
+        f.state = 1;
+        frames.push_back(Frame{as.value});
+      } else {
+        Value *v = values.back();
+        values.pop_back();
+        values.push_back(emitAssign(as, v));
+        frames.pop_back();
+      }
+      break;
+    }
+    case ExprKind::Call: {
+      auto &call = static_cast<const CallExpr &>(*f.e);
+      if (f.state < call.args.size()) {
+        frames.push_back(Frame{call.args[f.state]});
+        // NOTE: f may dangle after push_back; re-fetch.
+        frames[frames.size() - 2].state++;
+      } else {
+        std::vector<Value *> args(values.end() - static_cast<std::ptrdiff_t>(call.args.size()),
+                                  values.end());
+        values.resize(values.size() - call.args.size());
+        values.push_back(emitCall(call, std::move(args)));
+        frames.pop_back();
+      }
+      break;
+    }
+    case ExprKind::Binary: {
+      auto &bin = static_cast<const BinaryExpr &>(*f.e);
+      bool logical =
+          shortCircuit && (bin.op == BinOp::LogicalAnd || bin.op == BinOp::LogicalOr);
+      if (!logical) {
+        if (f.state == 0) {
+          f.state = 1;
+          frames.push_back(Frame{bin.lhs});
+        } else if (f.state == 1) {
+          f.state = 2;
+          frames.push_back(Frame{bin.rhs});
+        } else {
+          Value *R = values.back(); values.pop_back();
+          Value *L = values.back(); values.pop_back();
+          values.push_back(emitBinary(bin, L, R));
+          frames.pop_back();
+        }
+        break;
+      }
+
+      bool isAnd = bin.op == BinOp::LogicalAnd;
+      if (f.state == 0) {
+        f.state = 1;
+        frames.push_back(Frame{bin.lhs});
+      } else if (f.state == 1) {
+        Value *L = values.back(); values.pop_back();
+        Value *lbool = builder->CreateICmpNE(L, ConstantInt::get(getIntType(), 0),
+                                             isAnd ? "and.lhs" : "or.lhs");
+        llvm::Function *fn = builder->GetInsertBlock()->getParent();
+        f.scratch = lbool;
+        f.lhsEnd = builder->GetInsertBlock();
+        BasicBlock *rhsBB = BasicBlock::Create(*context, isAnd ? "and.rhs" : "or.rhs", fn);
+        f.mergeBB = BasicBlock::Create(*context, isAnd ? "and.end" : "or.end");
+        // && only evaluates the rhs when the lhs was true; || when false.
+        if (isAnd) builder->CreateCondBr(lbool, rhsBB, f.mergeBB);
+        else builder->CreateCondBr(lbool, f.mergeBB, rhsBB);
+        builder->SetInsertPoint(rhsBB);
+        f.state = 2;
+        frames.push_back(Frame{bin.rhs});
+      } else {
+        Value *R = values.back(); values.pop_back();
+        Value *rbool = builder->CreateICmpNE(R, ConstantInt::get(getIntType(), 0),
+                                             isAnd ? "and.rhs.val" : "or.rhs.val");
+        BasicBlock *rhsEnd = builder->GetInsertBlock();
+        builder->CreateBr(f.mergeBB);
+        llvm::Function *fn = rhsEnd->getParent();
+        f.mergeBB->insertInto(fn);
+        builder->SetInsertPoint(f.mergeBB);
+        PHINode *phi = builder->CreatePHI(builder->getInt1Ty(), 2, isAnd ? "and.phi" : "or.phi");
+        phi->addIncoming(builder->getInt1(!isAnd), f.lhsEnd);
+        phi->addIncoming(rbool, rhsEnd);
+        values.push_back(builder->CreateZExt(phi, getIntType(), isAnd ? "andtmp" : "ortmp"));
+        frames.pop_back();
+      }
+      break;
+    }
+    }
+  }
+
+  return values.back();
+}
+
+Value *CodeGen::emitBinary(const BinaryExpr &bin, Value *L, Value *R) {
+  switch (bin.op) {
+  case BinOp::Add: return builder->CreateAdd(L, R, "addtmp");
+  case BinOp::Sub: return builder->CreateSub(L, R, "subtmp");
+  case BinOp::Mul: return builder->CreateMul(L, R, "multmp");
+  case BinOp::Div: return builder->CreateSDiv(L, R, "divtmp");
+  case BinOp::Rem: return builder->CreateSRem(L, R, "remtmp");
+  case BinOp::Eq: return builder->CreateZExt(builder->CreateICmpEQ(L, R), getIntType(), "eqtmp");
+  case BinOp::Ne: return builder->CreateZExt(builder->CreateICmpNE(L, R), getIntType(), "netmp");
+  case BinOp::Lt: return builder->CreateZExt(builder->CreateICmpSLT(L, R), getIntType(), "lttmp");
+  case BinOp::Le: return builder->CreateZExt(builder->CreateICmpSLE(L, R), getIntType(), "letmp");
+  case BinOp::Gt: return builder->CreateZExt(builder->CreateICmpSGT(L, R), getIntType(), "gttmp");
+  case BinOp::Ge: return builder->CreateZExt(builder->CreateICmpSGE(L, R), getIntType(), "getmp");
+  case BinOp::LogicalAnd: {
+    // Eager fallback (-fno-short-circuit): (L != 0) & (R != 0)
     Value *lne = builder->CreateICmpNE(L, ConstantInt::get(getIntType(), 0));
     Value *rne = builder->CreateICmpNE(R, ConstantInt::get(getIntType(), 0));
     Value *andv = builder->CreateAnd(lne, rne);
     return builder->CreateZExt(andv, getIntType(), "andtmp");
   }
-  if (bin.op == "||") {
+  case BinOp::LogicalOr: {
     Value *lne = builder->CreateICmpNE(L, ConstantInt::get(getIntType(), 0));
     Value *rne = builder->CreateICmpNE(R, ConstantInt::get(getIntType(), 0));
     Value *orv = builder->CreateOr(lne, rne);
     return builder->CreateZExt(orv, getIntType(), "ortmp");
   }
-  throw std::runtime_error("Unknown binary operator: " + bin.op);
+  case BinOp::BitAnd: return builder->CreateAnd(L, R, "bandtmp");
+  case BinOp::BitOr: return builder->CreateOr(L, R, "bortmp");
+  case BinOp::BitXor: return builder->CreateXor(L, R, "bxortmp");
+  case BinOp::Shl: return builder->CreateShl(L, R, "shltmp");
+  // Arithmetic right shift, matching what gcc/clang do for signed int.
+  case BinOp::Shr: return builder->CreateAShr(L, R, "shrtmp");
+  }
+  throw std::runtime_error("Unknown binary operator");
 }
 
-Value *CodeGen::codegenUnary(const UnaryExpr &un) {
-  Value *V = codegenExpr(*un.operand);
-  if (un.op == "-") return builder->CreateNeg(V, "negtmp");
-  if (un.op == "+") return V;
-  if (un.op == "!") {
+Value *CodeGen::emitUnary(const UnaryExpr &un, Value *V) {
+  switch (un.op) {
+  case UnOp::Neg: return builder->CreateNeg(V, "negtmp");
+  case UnOp::Plus: return V;
+  case UnOp::Not: {
     Value *isZero = builder->CreateICmpEQ(V, ConstantInt::get(getIntType(), 0));
     return builder->CreateZExt(isZero, getIntType(), "nottmp");
   }
-  throw std::runtime_error("Unknown unary operator: " + un.op);
+  }
+  throw std::runtime_error("Unknown unary operator");
 }
 
-Value *CodeGen::codegenCall(const CallExpr &call) {
+Value *CodeGen::emitCall(const CallExpr &call, std::vector<Value *> args) {
   llvm::Function *callee = getFunction(call.callee);
-  if (!callee) throw std::runtime_error("Unknown function referenced: " + call.callee);
-  std::vector<Value*> argsV;
-  for (auto &a : call.args) argsV.push_back(codegenExpr(*a));
-  return builder->CreateCall(callee, argsV, call.callee == "printf" ? "" : "calltmp");
+  if (!callee)
+    throw std::runtime_error("Unknown function referenced: " + std::string(interner.spelling(call.callee)));
+  return builder->CreateCall(callee, args, interner.spelling(call.callee) == "printf" ? "" : "calltmp");
 }
 
-Value *CodeGen::codegenAssign(const AssignExpr &as) {
-  auto it = namedAllocas.find(as.name);
-  if (it == namedAllocas.end()) throw std::runtime_error("Unknown variable: " + as.name);
-  Value *val = codegenExpr(*as.value);
-  builder->CreateStore(val, it->second);
+Value *CodeGen::emitAssign(const AssignExpr &as, Value *val) {
+  AllocaInst *alloca = lookupAlloca(as.name);
+  if (!alloca)
+    throw std::runtime_error("Unknown variable: " + std::string(interner.spelling(as.name)));
+  builder->CreateStore(val, alloca);
   return val;
 }
 
 void CodeGen::codegenVarDecl(const VarDeclStmt &vd) {
   llvm::Function *func = builder->GetInsertBlock()->getParent();
-  AllocaInst *alloca = createEntryBlockAlloca(func, vd.name, getIntType(), *builder);
-  namedAllocas[vd.name] = alloca;
+  AllocaInst *alloca = createEntryBlockAlloca(func, toRef(interner.spelling(vd.name)), getIntType(), *builder);
+  ++stats->allocasCreated;
+  setAlloca(vd.name, alloca);
   if (vd.init) {
     Value *initV = codegenExpr(*vd.init);
     builder->CreateStore(initV, alloca);
@@ -154,14 +312,14 @@ void CodeGen::codegenIf(const IfStmt &ifs, llvm::Function *currentFunction) {
 
   builder->SetInsertPoint(thenBB);
   for (auto &s : ifs.thenStmts) codegenStmt(*s, currentFunction);
-  if (!thenBB->getTerminator()) builder->CreateBr(mergeBB);
+  if (!builder->GetInsertBlock()->getTerminator()) builder->CreateBr(mergeBB);
 
-  currentFunction->insert(currentFunction->end(), elseBB);
+  elseBB->insertInto(currentFunction);
   builder->SetInsertPoint(elseBB);
   for (auto &s : ifs.elseStmts) codegenStmt(*s, currentFunction);
-  if (!elseBB->getTerminator()) builder->CreateBr(mergeBB);
+  if (!builder->GetInsertBlock()->getTerminator()) builder->CreateBr(mergeBB);
 
-  currentFunction->insert(currentFunction->end(), mergeBB);
+  mergeBB->insertInto(currentFunction);
   builder->SetInsertPoint(mergeBB);
 }
 
@@ -177,49 +335,170 @@ void CodeGen::codegenWhile(const WhileStmt &ws, llvm::Function *currentFunction)
   condV = builder->CreateICmpNE(condV, ConstantInt::get(getIntType(), 0), "loopcond");
   builder->CreateCondBr(condV, bodyBB, afterBB);
 
-  currentFunction->insert(currentFunction->end(), bodyBB);
+  bodyBB->insertInto(currentFunction);
   builder->SetInsertPoint(bodyBB);
   for (auto &s : ws.body) codegenStmt(*s, currentFunction);
-  if (!bodyBB->getTerminator()) builder->CreateBr(condBB);
+  if (!builder->GetInsertBlock()->getTerminator()) builder->CreateBr(condBB);
 
-  currentFunction->insert(currentFunction->end(), afterBB);
+  afterBB->insertInto(currentFunction);
   builder->SetInsertPoint(afterBB);
 }
 
 void CodeGen::codegenStmt(const Stmt &stmt, llvm::Function *currentFunction) {
-  if (auto *r = dynamic_cast<const ReturnStmt*>(&stmt)) {
-    Value *retV = codegenExpr(*r->value);
-    builder->CreateRet(retV);
+  switch (stmt.kind) {
+  case StmtKind::Return:
+    builder->CreateRet(codegenExpr(*static_cast<const ReturnStmt &>(stmt).value));
     return;
-  }
-  if (auto *e = dynamic_cast<const ExprStmt*>(&stmt)) {
-    (void)codegenExpr(*e->expr);
+  case StmtKind::Expr:
+    (void)codegenExpr(*static_cast<const ExprStmt &>(stmt).expr);
+    return;
+  case StmtKind::VarDecl:
+    codegenVarDecl(static_cast<const VarDeclStmt &>(stmt));
+    return;
+  case StmtKind::If:
+    codegenIf(static_cast<const IfStmt &>(stmt), currentFunction);
+    return;
+  case StmtKind::While:
+    codegenWhile(static_cast<const WhileStmt &>(stmt), currentFunction);
     return;
   }
-  if (auto *v = dynamic_cast<const VarDeclStmt*>(&stmt)) { codegenVarDecl(*v); return; }
-  if (auto *i = dynamic_cast<const IfStmt*>(&stmt)) { codegenIf(*i, currentFunction); return; }
-  if (auto *w = dynamic_cast<const WhileStmt*>(&stmt)) { codegenWhile(*w, currentFunction); return; }
   throw std::runtime_error("Unhandled statement");
 }
 
-std::string CodeGen::emitIR(const TranslationUnit &tu) {
-  // First, declare externs and functions
+// Collects the names every function called from `fn`'s body, so a codegen
+// shard can declare just the callees it references instead of the whole
+// translation unit. Explicit stacks: expression trees can be deep.
+static void collectCallees(const ::Function &fn, std::set<Symbol> &out) {
+  std::vector<const Stmt *> stmts(fn.body.begin(), fn.body.end());
+  std::vector<const Expr *> exprs;
+  auto pushExpr = [&](const Expr *e) { if (e) exprs.push_back(e); };
+  while (!stmts.empty() || !exprs.empty()) {
+    if (!exprs.empty()) {
+      const Expr *e = exprs.back(); exprs.pop_back();
+      switch (e->kind) {
+      case ExprKind::Binary:
+        pushExpr(static_cast<const BinaryExpr *>(e)->lhs);
+        pushExpr(static_cast<const BinaryExpr *>(e)->rhs);
+        break;
+      case ExprKind::Unary: pushExpr(static_cast<const UnaryExpr *>(e)->operand); break;
+      case ExprKind::Assign: pushExpr(static_cast<const AssignExpr *>(e)->value); break;
+      case ExprKind::Call: {
+        auto *call = static_cast<const CallExpr *>(e);
+        out.insert(call->callee);
+        for (const Expr *a : call->args) pushExpr(a);
+        break;
+      }
+      case ExprKind::Number:
+      case ExprKind::Variable:
+        break;
+      }
+      continue;
+    }
+    const Stmt *s = stmts.back(); stmts.pop_back();
+    switch (s->kind) {
+    case StmtKind::Return: pushExpr(static_cast<const ReturnStmt *>(s)->value); break;
+    case StmtKind::Expr: pushExpr(static_cast<const ExprStmt *>(s)->expr); break;
+    case StmtKind::VarDecl: pushExpr(static_cast<const VarDeclStmt *>(s)->init); break;
+    case StmtKind::If: {
+      auto *ifs = static_cast<const IfStmt *>(s);
+      pushExpr(ifs->cond);
+      stmts.insert(stmts.end(), ifs->thenStmts.begin(), ifs->thenStmts.end());
+      stmts.insert(stmts.end(), ifs->elseStmts.begin(), ifs->elseStmts.end());
+      break;
+    }
+    case StmtKind::While: {
+      auto *ws = static_cast<const WhileStmt *>(s);
+      pushExpr(ws->cond);
+      stmts.insert(stmts.end(), ws->body.begin(), ws->body.end());
+      break;
+    }
+    }
+  }
+}
+
+// Marks the functions reachable from main() over CallExpr callee names.
+// Our generated units bundle big utility libraries of which a given binary
+// uses a fraction; emitting (and verifying, and optimizing) only the live
+// part shrinks everything downstream. Without a main() every function is a
+// root: the unit is a library and all of it is exported.
+static std::vector<bool> computeLiveSet(const TranslationUnit &tu, const Interner &interner) {
+  std::vector<bool> live(tu.functions.size(), false);
+  std::map<Symbol, std::size_t> indexByName;
+  std::size_t mainIndex = tu.functions.size();
+  for (std::size_t i = 0; i < tu.functions.size(); ++i) {
+    indexByName[tu.functions[i]->name] = i;
+    if (interner.spelling(tu.functions[i]->name) == "main") mainIndex = i;
+  }
+  if (mainIndex == tu.functions.size()) return std::vector<bool>(tu.functions.size(), true);
+
+  std::vector<std::size_t> worklist{mainIndex};
+  live[mainIndex] = true;
+  std::set<Symbol> callees;
+  while (!worklist.empty()) {
+    std::size_t i = worklist.back();
+    worklist.pop_back();
+    callees.clear();
+    collectCallees(*tu.functions[i], callees);
+    for (Symbol name : callees) {
+      auto it = indexByName.find(name);
+      if (it == indexByName.end() || live[it->second]) continue;
+      live[it->second] = true;
+      worklist.push_back(it->second);
+    }
+  }
+  return live;
+}
+
+void CodeGen::buildModule(const TranslationUnit &tu, std::size_t shardIndex, std::size_t shardCount,
+                          const std::vector<bool> *sharedLive) {
+  std::vector<bool> ownLive;
+  if (!sharedLive && !emitAll) ownLive = computeLiveSet(tu, interner);
+  const std::vector<bool> &live = sharedLive ? *sharedLive : ownLive;
+  auto isLive = [&](std::size_t i) { return live.empty() || live[i]; };
+
+  // Externs are declared everywhere (shared prelude, cheap); functions only
+  // where defined or referenced, so shard bitcode stays proportional to the
+  // shard instead of the whole translation unit. The linker merges the
+  // cross-shard declarations with their one definition.
   for (auto &e : tu.externs) declareExtern(*e);
-  for (auto &f : tu.functions) declareFunction(*f);
+  if (shardCount <= 1) {
+    for (std::size_t i = 0; i < tu.functions.size(); ++i) {
+      if (isLive(i)) declareFunction(*tu.functions[i]);
+    }
+  } else {
+    std::map<Symbol, const ::Function *> byName;
+    for (auto &f : tu.functions) byName[f->name] = f;
+    std::set<Symbol> callees;
+    for (std::size_t i = shardIndex; i < tu.functions.size(); i += shardCount) {
+      if (!isLive(i)) continue;
+      declareFunction(*tu.functions[i]);
+      collectCallees(*tu.functions[i], callees);
+    }
+    for (Symbol name : callees) {
+      if (getFunction(name)) continue;
+      auto it = byName.find(name);
+      if (it != byName.end()) declareFunction(*it->second);
+    }
+  }
 
-  for (auto &fup : tu.functions) {
-    llvm::Function *f = module->getFunction(fup->name);
+  for (std::size_t i = shardIndex; i < tu.functions.size(); i += shardCount) {
+    if (!isLive(i)) continue;
+    const ::Function *fup = tu.functions[i];
+    llvm::Function *f = module->getFunction(toRef(interner.spelling(fup->name)));
     if (!f) throw std::runtime_error("Function not found after declaration");
 
     BasicBlock *entry = BasicBlock::Create(*context, "entry", f);
     builder->SetInsertPoint(entry);
 
-    namedAllocas.clear();
+    ++allocaEpoch;
     // Create allocas for params and store incoming values
     unsigned idx = 0;
     for (auto &arg : f->args()) {
-      auto alloca = createEntryBlockAlloca(f, std::string(arg.getName()), getIntType(), *builder);
-      namedAllocas[std::string(arg.getName())] = alloca;
+      auto alloca = createEntryBlockAlloca(f, arg.getName(), getIntType(), *builder);
+      ++stats->allocasCreated;
+      // Key by the param's slice of the source buffer so lookups against
+      // VariableExpr names compare equal views.
+      setAlloca(fup->params[idx].name, alloca);
       builder->CreateStore(&arg, alloca);
       idx++;
     }
@@ -228,24 +507,204 @@ std::string CodeGen::emitIR(const TranslationUnit &tu) {
       codegenStmt(*s, f);
     }
 
-    // Ensure function is properly terminated
-    if (!entry->getTerminator()) {
+    // Ensure the function is properly terminated: the builder may have
+    // moved past `entry` into a merge block by now.
+    if (!builder->GetInsertBlock()->getTerminator()) {
       // Default return 0 if no explicit return
       builder->CreateRet(ConstantInt::get(getIntType(), 0));
     }
 
-    if (verifyFunction(*f, &errs())) {
+    for (const BasicBlock &bb : *f) stats->instructionsEmitted += bb.size();
+
+    // Per-function checking on top of the module pass is Full-tier only:
+    // it verifies every instruction at least twice and shows up as a
+    // top-three cost on large modules.
+    if (verifyMode == VerifyMode::Full && verifyFunction(*f, &errs())) {
       throw std::runtime_error("Generated invalid function IR");
     }
   }
 
-  if (verifyModule(*module, &errs())) {
+}
+
+void CodeGen::generate(const TranslationUnit &tu) {
+  buildModule(tu, 0, 1);
+
+  if (verifyMode != VerifyMode::None && verifyModule(*module, &errs())) {
     throw std::runtime_error("Generated invalid module IR");
   }
 
+  if (optLevel > 0) optimize();
+}
+
+void CodeGen::optimize() {
+  PassBuilder pb;
+  LoopAnalysisManager lam;
+  FunctionAnalysisManager fam;
+  CGSCCAnalysisManager cgam;
+  ModuleAnalysisManager mam;
+  pb.registerModuleAnalyses(mam);
+  pb.registerCGSCCAnalyses(cgam);
+  pb.registerFunctionAnalyses(fam);
+  pb.registerLoopAnalyses(lam);
+  pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+  OptimizationLevel level = optLevel >= 2 ? OptimizationLevel::O2 : OptimizationLevel::O1;
+  ModulePassManager mpm = pb.buildPerModuleDefaultPipeline(level);
+  mpm.run(*module, mam);
+}
+
+std::string CodeGen::emitIR(const TranslationUnit &tu) {
   std::string ir;
   raw_string_ostream os(ir);
+  emitIRText(tu, os);
+  os.flush();
+  return ir;
+}
+
+void CodeGen::emitIRText(const TranslationUnit &tu, raw_ostream &os) {
+  generate(tu);
   module->print(os, nullptr);
   os.flush();
+}
+
+void CodeGen::emitBitcode(const TranslationUnit &tu, raw_ostream &os) {
+  generate(tu);
+  WriteBitcodeToFile(*module, os);
+  os.flush();
+}
+
+void CodeGen::emitObject(const TranslationUnit &tu, raw_pwrite_stream &os) {
+  generate(tu);
+
+  initializeNativeTargetOnce();
+
+  std::string triple = sys::getDefaultTargetTriple();
+  std::string lookupError;
+  const Target *target = TargetRegistry::lookupTarget(triple, lookupError);
+  if (!target) throw std::runtime_error("No target for " + triple + ": " + lookupError);
+
+  TargetOptions options;
+  std::unique_ptr<TargetMachine> tm(
+      target->createTargetMachine(triple, "generic", "", options, Reloc::PIC_));
+  if (!tm) throw std::runtime_error("Could not create target machine for " + triple);
+
+  module->setTargetTriple(triple);
+  module->setDataLayout(tm->createDataLayout());
+
+  legacy::PassManager pm;
+  if (tm->addPassesToEmitFile(pm, os, nullptr, CGFT_ObjectFile)) {
+    throw std::runtime_error("Target cannot emit object files");
+  }
+  pm.run(*module);
+  os.flush();
+}
+
+int CodeGen::runJIT(const TranslationUnit &tu) {
+  generate(tu);
+
+  initializeNativeTargetOnce();
+
+  auto jit = orc::LLJITBuilder().create();
+  if (!jit) throw std::runtime_error("Failed to create JIT: " + toString(jit.takeError()));
+
+  // Externs (putchar and friends) resolve against the host process.
+  auto generator = orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+      (*jit)->getDataLayout().getGlobalPrefix());
+  if (!generator)
+    throw std::runtime_error("Failed to set up process symbols: " + toString(generator.takeError()));
+  (*jit)->getMainJITDylib().addGenerator(std::move(*generator));
+
+  if (auto err = (*jit)->addIRModule(orc::ThreadSafeModule(std::move(module), std::move(context))))
+    throw std::runtime_error("Failed to add module to JIT: " + toString(std::move(err)));
+
+  auto sym = (*jit)->lookup("main");
+  if (!sym) throw std::runtime_error("No main() to run: " + toString(sym.takeError()));
+
+  auto *entry = reinterpret_cast<int (*)()>(static_cast<std::uintptr_t>(sym->getAddress()));
+  return entry();
+}
+
+std::string CodeGen::emitIRParallel(const TranslationUnit &tu, const std::string &moduleName,
+                                    const Interner &interner, unsigned jobs,
+                                    unsigned optLevel, bool shortCircuit, bool emitAll,
+                                    VerifyMode verify) {
+  std::string ir;
+  raw_string_ostream os(ir);
+  emitIRParallelTo(tu, moduleName, interner, jobs, os, optLevel, shortCircuit, emitAll, verify);
+  os.flush();
   return ir;
 }
+
+void CodeGen::emitIRParallelTo(const TranslationUnit &tu, const std::string &moduleName,
+                               const Interner &interner, unsigned jobs, raw_ostream &sink,
+                               unsigned optLevel, bool shortCircuit, bool emitAll,
+                               VerifyMode verify) {
+  if (tu.functions.size() < 2 || jobs < 2) {
+    CodeGen(moduleName, interner, optLevel, nullptr, shortCircuit, emitAll, verify)
+        .emitIRText(tu, sink);
+    return;
+  }
+  if (jobs > tu.functions.size()) jobs = static_cast<unsigned>(tu.functions.size());
+
+  // Each worker generates its shard in a private context and prints its
+  // functions to text; textual IR tolerates forward references between
+  // functions, so the driver just stitches the pieces back together in
+  // source order -- no bitcode round trip, no serial relink.
+  // Reachability is shard-invariant; compute it once for all workers.
+  std::vector<bool> live;
+  if (!emitAll) live = computeLiveSet(tu, interner);
+
+  std::vector<std::string> fnText(tu.functions.size());
+  std::vector<std::exception_ptr> errors(jobs);
+  std::vector<std::thread> workers;
+  workers.reserve(jobs);
+  for (unsigned w = 0; w < jobs; ++w) {
+    workers.emplace_back([&, w] {
+      try {
+        CodeGen cg(moduleName, interner, optLevel, nullptr, shortCircuit, emitAll, verify);
+        cg.buildModule(tu, w, jobs, emitAll ? nullptr : &live);
+        if (verify != VerifyMode::None && verifyModule(*cg.module, &errs())) {
+          throw std::runtime_error("Generated invalid module IR");
+        }
+        // Optimizing per shard parallelizes the pass pipeline too; the
+        // trade is no cross-shard inlining.
+        if (optLevel > 0) cg.optimize();
+        for (std::size_t i = w; i < tu.functions.size(); i += jobs) {
+          llvm::Function *f = cg.module->getFunction(toRef(interner.spelling(tu.functions[i]->name)));
+          if (!f || f->isDeclaration()) continue; // dead under lazy codegen
+          // Standalone function printing emits function-level attributes as
+          // "#N" group references without ever emitting the group
+          // definitions, leaving dangling references the textual parser
+          // only tolerates by silently treating them as empty. Strip them
+          // so sharded -O output is self-contained and explicit about not
+          // carrying function attributes; return and parameter attributes
+          // print inline and survive.
+          f->setAttributes(f->getAttributes().removeAttributesAtIndex(
+              *cg.context, AttributeList::FunctionIndex));
+          raw_string_ostream os(fnText[i]);
+          f->print(os);
+          os.flush();
+        }
+      } catch (...) {
+        errors[w] = std::current_exception();
+      }
+    });
+  }
+  for (auto &t : workers) t.join();
+  for (auto &err : errors) {
+    if (err) std::rethrow_exception(err);
+  }
+
+  // Module header and extern declarations come from a declarations-only
+  // module so the streamed output matches the serial printer's layout; the
+  // per-function pieces then flow to the sink one by one instead of being
+  // concatenated into one giant string.
+  CodeGen header(moduleName, interner);
+  for (auto &e : tu.externs) header.declareExtern(*e);
+  header.module->print(sink, nullptr);
+  for (auto &text : fnText) {
+    if (text.empty()) continue; // dead under lazy codegen
+    sink << "\n" << text;
+  }
+  sink.flush();
+}
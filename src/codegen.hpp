@@ -1,9 +1,12 @@
 #pragma once
 
 #include "ast.hpp"
-#include <map>
+#include "interner.hpp"
+#include "stats.hpp"
 #include <memory>
+#include <vector>
 #include <string>
+#include <string_view>
 
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
@@ -13,33 +16,105 @@
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Instructions.h>
 
+// How much IR verification to pay for: Full re-checks every function as it
+// is generated plus the whole module (every instruction verified at least
+// twice -- CI material); Module is one whole-module pass (the default);
+// None is for release pipelines that trust their inputs.
+enum class VerifyMode { None, Module, Full };
+
 class CodeGen {
 public:
-  explicit CodeGen(const std::string &moduleName);
+  // optLevel 0-2 selects the New PM default pipeline run over the module
+  // after generation (0 = none, the historical behavior). The interner is
+  // the one the input was lexed with; it supplies spellings for LLVM names
+  // and bounds the dense symbol table.
+  CodeGen(const std::string &moduleName, const Interner &interner, unsigned optLevel = 0,
+          CompileStats *stats = nullptr, bool shortCircuit = true, bool emitAll = false,
+          VerifyMode verify = VerifyMode::Module);
 
   std::string emitIR(const TranslationUnit &tu);
 
+  // Sink-based backends: textual IR, bitcode or a target object file flow
+  // straight to the stream -- nothing is materialized in memory first.
+  void emitIRText(const TranslationUnit &tu, llvm::raw_ostream &os);
+  void emitBitcode(const TranslationUnit &tu, llvm::raw_ostream &os);
+  void emitObject(const TranslationUnit &tu, llvm::raw_pwrite_stream &os);
+
+  // Hand the freshly built module to an in-process ORC LLJIT and call
+  // main() directly: no serialization, no temp files, no extra processes.
+  // Returns the program's exit code.
+  int runJIT(const TranslationUnit &tu);
+
+  // Shard tu.functions across `jobs` worker threads, each generating its
+  // shard in a private LLVMContext/Module, then link the shards back into
+  // one module. Falls back to the serial path for jobs <= 1.
+  static std::string emitIRParallel(const TranslationUnit &tu, const std::string &moduleName,
+                                    const Interner &interner, unsigned jobs,
+                                    unsigned optLevel = 0, bool shortCircuit = true,
+                                    bool emitAll = false, VerifyMode verify = VerifyMode::Module);
+  static void emitIRParallelTo(const TranslationUnit &tu, const std::string &moduleName,
+                               const Interner &interner, unsigned jobs, llvm::raw_ostream &os,
+                               unsigned optLevel = 0, bool shortCircuit = true,
+                               bool emitAll = false, VerifyMode verify = VerifyMode::Module);
+
 private:
   std::unique_ptr<llvm::LLVMContext> context;
   std::unique_ptr<llvm::Module> module;
   std::unique_ptr<llvm::IRBuilder<>> builder;
+  const Interner &interner;
+  unsigned optLevel{0};
+  CompileStats *stats; // never null; defaults to the discard sink
+  bool shortCircuit{true}; // -fno-short-circuit restores eager && / ||
+  bool emitAll{false};     // --emit-all restores emit-everything codegen
+  VerifyMode verifyMode{VerifyMode::Module};
+
+  // Dense symbol table: interned ids index straight into the vector (the
+  // interner is a perfect hash), and an epoch stamp per entry makes the
+  // per-function reset a single counter bump instead of a clear().
+  std::vector<std::pair<std::uint32_t, llvm::AllocaInst *>> allocaBySymbol;
+  std::uint32_t allocaEpoch{0};
+
+  llvm::AllocaInst *lookupAlloca(Symbol sym) const {
+    if (sym >= allocaBySymbol.size()) return nullptr;
+    const auto &entry = allocaBySymbol[sym];
+    return entry.first == allocaEpoch ? entry.second : nullptr;
+  }
+  void setAlloca(Symbol sym, llvm::AllocaInst *alloca) {
+    if (sym >= allocaBySymbol.size()) allocaBySymbol.resize(interner.size());
+    allocaBySymbol[sym] = {allocaEpoch, alloca};
+  }
+
+  // Declares everything, then generates bodies for functions whose index
+  // satisfies i % shardCount == shardIndex. (0, 1) builds the whole module.
+  // `sharedLive` lets parallel codegen compute the reachability set once
+  // and hand it to every shard.
+  void buildModule(const TranslationUnit &tu, std::size_t shardIndex, std::size_t shardCount,
+                   const std::vector<bool> *sharedLive = nullptr);
+
+  // buildModule(tu, 0, 1) plus whole-module verification and, for
+  // optLevel > 0, the optimization pipeline.
+  void generate(const TranslationUnit &tu);
 
-  // Map variable name to its stack allocation (alloca)
-  std::map<std::string, llvm::AllocaInst*> namedAllocas;
+  // Runs the New PM per-module default pipeline (mem2reg/SROA, instcombine,
+  // simplifycfg and friends) in-process -- no separate opt invocation, no
+  // serialize/parse round trip.
+  void optimize();
 
   llvm::Type *getIntType();
-  llvm::Function *getFunction(const std::string &name);
+  llvm::Function *getFunction(Symbol name);
 
   // Declaration helpers
   llvm::Function *declareExtern(const ExternDecl &decl);
   llvm::Function *declareFunction(const ::Function &fn);
 
-  // Codegen helpers
+  // Codegen: codegenExpr drives an explicit work stack (expressions come
+  // in thousands of operators deep; see the Frame machine in codegen.cpp);
+  // the emit* helpers fire once a node's operands are all materialized.
   llvm::Value *codegenExpr(const Expr &expr);
-  llvm::Value *codegenBinary(const BinaryExpr &bin);
-  llvm::Value *codegenUnary(const UnaryExpr &un);
-  llvm::Value *codegenCall(const CallExpr &call);
-  llvm::Value *codegenAssign(const AssignExpr &as);
+  llvm::Value *emitBinary(const BinaryExpr &bin, llvm::Value *L, llvm::Value *R);
+  llvm::Value *emitUnary(const UnaryExpr &un, llvm::Value *V);
+  llvm::Value *emitCall(const CallExpr &call, std::vector<llvm::Value *> args);
+  llvm::Value *emitAssign(const AssignExpr &as, llvm::Value *val);
 
   void codegenStmt(const Stmt &stmt, llvm::Function *currentFunction);
   void codegenVarDecl(const VarDeclStmt &vd);
@@ -0,0 +1,107 @@
+#include "compile_session.hpp"
+
+#include "fold.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <stdexcept>
+
+CompileSession::CompileSession(CompileOptions options) : opts(std::move(options)) {}
+
+CompileSession::~CompileSession() = default;
+
+TranslationUnit &CompileSession::frontEnd(std::string_view source) {
+  stats = CompileStats{};
+  diag = DiagnosticEngine{};
+
+  interner.reset();
+  if (!tu) {
+    tu = std::make_unique<TranslationUnit>();
+  } else {
+    tu->externs.clear();
+    tu->functions.clear();
+    tu->arena.reset();
+  }
+
+  if (prelude) prelude->inject(*tu, interner);
+
+  {
+    PhaseTimer t(stats.lexWall, stats.lexCpu);
+    Lexer lex(source, interner, &diag);
+    lex.lexAll(tokens);
+  }
+  stats.tokensLexed = tokens.size();
+
+  {
+    PhaseTimer t(stats.parseWall, stats.parseCpu);
+    Parser parser(std::move(tokens), &stats, &diag);
+    parser.parseInto(*tu);
+    tokens = parser.takeTokens();
+  }
+
+  if (diag.hasErrors())
+    throw std::runtime_error(std::to_string(diag.errorCount()) + " error(s) generated");
+
+  if (opts.fold) {
+    PhaseTimer t(stats.foldWall, stats.foldCpu);
+    foldTranslationUnit(*tu);
+  }
+  return *tu;
+}
+
+CodeGen CompileSession::makeCodeGen() {
+  return CodeGen(opts.moduleName, interner, opts.optLevel, &stats, opts.shortCircuit,
+                 opts.emitAll, opts.verify);
+}
+
+void CompileSession::compileTo(std::string_view source, OutputKind kind,
+                               llvm::raw_pwrite_stream &os) {
+  TranslationUnit &unit = frontEnd(source);
+  PhaseTimer t(stats.codegenWall, stats.codegenCpu);
+  switch (kind) {
+  case OutputKind::IR:
+    if (opts.jobs > 1) {
+      CodeGen::emitIRParallelTo(unit, opts.moduleName, interner, opts.jobs, os, opts.optLevel,
+                                opts.shortCircuit, opts.emitAll, opts.verify);
+    } else {
+      makeCodeGen().emitIRText(unit, os);
+    }
+    break;
+  case OutputKind::Bitcode:
+    makeCodeGen().emitBitcode(unit, os);
+    break;
+  case OutputKind::Object:
+    makeCodeGen().emitObject(unit, os);
+    break;
+  }
+}
+
+// The in-memory forms collect through an svector sink (object emission
+// requires a pwrite stream).
+static std::string collect(CompileSession &session, std::string_view source, OutputKind kind) {
+  llvm::SmallVector<char, 0> bytes;
+  llvm::raw_svector_ostream os(bytes);
+  session.compileTo(source, kind, os);
+  return std::string(bytes.data(), bytes.size());
+}
+
+std::string CompileSession::compileIR(std::string_view source) {
+  return collect(*this, source, OutputKind::IR);
+}
+
+std::string CompileSession::compileBitcode(std::string_view source) {
+  return collect(*this, source, OutputKind::Bitcode);
+}
+
+std::string CompileSession::compileObject(std::string_view source) {
+  return collect(*this, source, OutputKind::Object);
+}
+
+int CompileSession::runMain(std::string_view source) {
+  TranslationUnit &unit = frontEnd(source);
+  PhaseTimer t(stats.codegenWall, stats.codegenCpu);
+  CodeGen cg = makeCodeGen();
+  return cg.runJIT(unit);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "codegen.hpp"
+#include "diag.hpp"
+#include "interner.hpp"
+#include "prelude.hpp"
+#include "stats.hpp"
+#include "token.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// What the compiler writes to its sink.
+enum class OutputKind { IR, Bitcode, Object };
+
+// Everything that shapes a compilation besides the source bytes.
+struct CompileOptions {
+  std::string moduleName{"module"};
+  unsigned jobs{1};        // function-level codegen parallelism (IR only)
+  unsigned optLevel{0};    // 0-2, New PM default pipelines
+  bool fold{true};         // AST constant folding
+  bool shortCircuit{true}; // real && / || control flow
+  bool emitAll{false};     // emit unreachable functions too
+  VerifyMode verify{VerifyMode::Module};
+};
+
+// Embeddable compiler instance: accepts in-memory buffers and returns the
+// result in-memory, no files and no processes. A session owns the reusable
+// per-compilation pools (token buffer, AST arena, interner), so compiling
+// many buffers through one session reaches the same steady-state zero
+// malloc behavior as the server. Sessions are independent: run one per
+// thread for concurrent compilation; a single session is not thread-safe.
+//
+// Lex/parse errors throw std::runtime_error with a count summary; the full
+// batch is available from diagnostics() and can be printed with
+// reportDiagnostics(). The source buffer only needs to outlive the call.
+class CompileSession {
+public:
+  explicit CompileSession(CompileOptions options = {});
+  ~CompileSession();
+
+  CompileSession(const CompileSession &) = delete;
+  CompileSession &operator=(const CompileSession &) = delete;
+
+  // Injected before every compile until cleared; not owned.
+  void setPrelude(const PreludeCache *prelude) { this->prelude = prelude; }
+
+  // Sink form: the output (textual IR, bitcode or object bytes) flows to
+  // `os` incrementally, never materializing in memory -- hand it a
+  // buffered raw_fd_ostream to stream a hundreds-of-MB module to disk
+  // without doubling peak RSS at the end of the compile.
+  void compileTo(std::string_view source, OutputKind kind, llvm::raw_pwrite_stream &os);
+
+  // In-memory conveniences over compileTo.
+  std::string compileIR(std::string_view source);
+  std::string compileBitcode(std::string_view source);
+  std::string compileObject(std::string_view source);
+
+  // Builds the module and executes main() in-process; returns its result.
+  int runMain(std::string_view source);
+
+  const CompileOptions &options() const { return opts; }
+
+  // Stats and diagnostics of the most recent compile.
+  const CompileStats &lastStats() const { return stats; }
+  const DiagnosticEngine &diagnostics() const { return diag; }
+  // `source` must be the buffer passed to the failing compile; offsets are
+  // resolved through a lazily built line map.
+  void reportDiagnostics(std::ostream &os, const std::string &path, std::string_view source) const {
+    diag.report(os, path, source);
+  }
+
+private:
+  CompileOptions opts;
+  const PreludeCache *prelude{nullptr};
+
+  // Pooled across compiles: reset, not freed.
+  std::vector<Token> tokens;
+  Interner interner;
+  TUPtr tu;
+
+  CompileStats stats;
+  DiagnosticEngine diag;
+
+  // Lex, parse and fold `source` into the pooled unit.
+  TranslationUnit &frontEnd(std::string_view source);
+  CodeGen makeCodeGen();
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "line_map.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Collected diagnostics for one compilation. The lexer and parser record
+// errors here and recover instead of throwing on the first problem, so a
+// single pass over a bad file reports everything it can find; the driver
+// prints the batch and fails the compile afterwards.
+struct Diagnostic {
+  std::size_t offset{0}; // byte offset into the source buffer
+  std::string message;
+};
+
+class DiagnosticEngine {
+public:
+  void error(std::size_t offset, std::string message) {
+    diags.push_back(Diagnostic{offset, std::move(message)});
+  }
+
+  bool hasErrors() const { return !diags.empty(); }
+  std::size_t errorCount() const { return diags.size(); }
+
+  // clang-style "path:line:col: error: message" lines. Builds the line map
+  // here, on the error path only; `source` must be the buffer the offsets
+  // were recorded against.
+  void report(std::ostream &os, const std::string &path, std::string_view source) const {
+    LineMap map(source);
+    for (const Diagnostic &d : diags) {
+      LineMap::LineCol loc = map.locate(d.offset);
+      os << path << ":" << loc.line << ":" << loc.column << ": error: " << d.message << "\n";
+    }
+  }
+
+private:
+  std::vector<Diagnostic> diags;
+};
@@ -0,0 +1,190 @@
+#include "fold.hpp"
+
+#include <climits>
+#include <cstdint>
+
+namespace {
+
+bool isConst(const Expr *e, long long &value) {
+  if (e->kind != ExprKind::Number) return false;
+  // Literals are emitted as i32, so fold in the same domain: truncating
+  // here keeps every rule below (and the if/while condition checks)
+  // congruent with what -fno-fold produces at runtime -- a raw 4294967296
+  // is 0 on the target, not "nonzero".
+  value = static_cast<std::int32_t>(static_cast<const NumberExpr *>(e)->value);
+  return true;
+}
+
+// Two's-complement wrapping, so folding huge constants stays defined
+// behavior in the compiler itself.
+long long wrapAdd(long long l, long long r) {
+  return static_cast<long long>(static_cast<unsigned long long>(l) + static_cast<unsigned long long>(r));
+}
+long long wrapSub(long long l, long long r) {
+  return static_cast<long long>(static_cast<unsigned long long>(l) - static_cast<unsigned long long>(r));
+}
+long long wrapMul(long long l, long long r) {
+  return static_cast<long long>(static_cast<unsigned long long>(l) * static_cast<unsigned long long>(r));
+}
+
+// Folds two known constants (already truncated to i32 by isConst, so
+// every rule evaluates in the emitted type's domain). Division and
+// remainder by zero -- and INT32_MIN / -1 -- stay unfolded so the behavior
+// (whatever the target does) remains a runtime matter.
+bool evalBinary(BinOp op, long long l, long long r, long long &out) {
+  switch (op) {
+  case BinOp::Add: out = wrapAdd(l, r); return true;
+  case BinOp::Sub: out = wrapSub(l, r); return true;
+  case BinOp::Mul: out = wrapMul(l, r); return true;
+  case BinOp::Div: if (r == 0 || (l == INT32_MIN && r == -1)) return false; out = l / r; return true;
+  case BinOp::Rem: if (r == 0 || (l == INT32_MIN && r == -1)) return false; out = l % r; return true;
+  case BinOp::Eq: out = l == r; return true;
+  case BinOp::Ne: out = l != r; return true;
+  case BinOp::Lt: out = l < r; return true;
+  case BinOp::Le: out = l <= r; return true;
+  case BinOp::Gt: out = l > r; return true;
+  case BinOp::Ge: out = l >= r; return true;
+  case BinOp::LogicalAnd: out = (l != 0) && (r != 0); return true;
+  case BinOp::LogicalOr: out = (l != 0) || (r != 0); return true;
+  case BinOp::BitAnd: out = l & r; return true;
+  case BinOp::BitOr: out = l | r; return true;
+  case BinOp::BitXor: out = l ^ r; return true;
+  // Shifts fold in i32 semantics (the emitted type); out-of-range counts
+  // stay a runtime matter.
+  case BinOp::Shl:
+    if (r < 0 || r > 31) return false;
+    out = static_cast<std::int32_t>(static_cast<std::uint32_t>(static_cast<std::int32_t>(l)) << r);
+    return true;
+  case BinOp::Shr:
+    if (r < 0 || r > 31) return false;
+    out = static_cast<std::int32_t>(l) >> r;
+    return true;
+  }
+  return false;
+}
+
+// Post-order rewrite with an explicit stack of child slots, so folding a
+// thousands-deep operator chain doesn't recurse. Each slot is visited
+// twice: first to queue its children, then to apply the local rules once
+// they are folded.
+ExprPtr foldExpr(ExprPtr root, Arena &arena) {
+  struct Slot {
+    ExprPtr *ref;
+    bool childrenQueued;
+  };
+  std::vector<Slot> work;
+  work.push_back(Slot{&root, false});
+
+  while (!work.empty()) {
+    Slot slot = work.back();
+    work.pop_back();
+    Expr *e = *slot.ref;
+
+    if (!slot.childrenQueued) {
+      switch (e->kind) {
+      case ExprKind::Number:
+      case ExprKind::Variable:
+        continue;
+      case ExprKind::Binary: {
+        auto *bin = static_cast<BinaryExpr *>(e);
+        work.push_back(Slot{slot.ref, true});
+        work.push_back(Slot{&bin->lhs, false});
+        work.push_back(Slot{&bin->rhs, false});
+        continue;
+      }
+      case ExprKind::Unary:
+        work.push_back(Slot{slot.ref, true});
+        work.push_back(Slot{&static_cast<UnaryExpr *>(e)->operand, false});
+        continue;
+      case ExprKind::Call: {
+        auto *call = static_cast<CallExpr *>(e);
+        for (auto &arg : call->args) work.push_back(Slot{&arg, false});
+        continue;
+      }
+      case ExprKind::Assign:
+        work.push_back(Slot{&static_cast<AssignExpr *>(e)->value, false});
+        continue;
+      }
+      continue;
+    }
+
+    // Children folded; apply the local rules.
+    switch (e->kind) {
+    case ExprKind::Binary: {
+      auto *bin = static_cast<BinaryExpr *>(e);
+      long long l, r, v;
+      if (isConst(bin->lhs, l) && isConst(bin->rhs, r) && evalBinary(bin->op, l, r, v))
+        *slot.ref = arena.create<NumberExpr>(v);
+      break;
+    }
+    case ExprKind::Unary: {
+      auto *un = static_cast<UnaryExpr *>(e);
+      if (un->op == UnOp::Plus) { *slot.ref = un->operand; break; } // +x is x
+      long long v;
+      if (isConst(un->operand, v))
+        *slot.ref = arena.create<NumberExpr>(un->op == UnOp::Neg ? wrapSub(0, v) : !v);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return root;
+}
+
+void foldStmtList(StmtList &stmts, Arena &arena);
+
+// Folds one statement; a constant-condition if/while collapses into its
+// live branch, which is spliced into `out` (possibly as nothing at all).
+void foldStmt(StmtPtr s, StmtList &out, Arena &arena) {
+  switch (s->kind) {
+  case StmtKind::Return:
+    static_cast<ReturnStmt *>(s)->value = foldExpr(static_cast<ReturnStmt *>(s)->value, arena);
+    break;
+  case StmtKind::Expr:
+    static_cast<ExprStmt *>(s)->expr = foldExpr(static_cast<ExprStmt *>(s)->expr, arena);
+    break;
+  case StmtKind::VarDecl: {
+    auto *vd = static_cast<VarDeclStmt *>(s);
+    if (vd->init) vd->init = foldExpr(vd->init, arena);
+    break;
+  }
+  case StmtKind::If: {
+    auto *ifs = static_cast<IfStmt *>(s);
+    ifs->cond = foldExpr(ifs->cond, arena);
+    foldStmtList(ifs->thenStmts, arena);
+    foldStmtList(ifs->elseStmts, arena);
+    long long c;
+    if (isConst(ifs->cond, c)) {
+      auto &live = c != 0 ? ifs->thenStmts : ifs->elseStmts;
+      out.append(live.begin(), live.end());
+      return;
+    }
+    break;
+  }
+  case StmtKind::While: {
+    auto *ws = static_cast<WhileStmt *>(s);
+    ws->cond = foldExpr(ws->cond, arena);
+    foldStmtList(ws->body, arena);
+    long long c;
+    // Only while (0) folds away; a constant non-zero condition is an
+    // intentional (or at least explicit) infinite loop.
+    if (isConst(ws->cond, c) && c == 0) return;
+    break;
+  }
+  }
+  out.push_back(s);
+}
+
+void foldStmtList(StmtList &stmts, Arena &arena) {
+  StmtList folded;
+  folded.reserve(stmts.size());
+  for (StmtPtr s : stmts) foldStmt(s, folded, arena);
+  stmts = std::move(folded);
+}
+
+} // namespace
+
+void foldTranslationUnit(TranslationUnit &tu) {
+  for (Function *fn : tu.functions) foldStmtList(fn->body, tu.arena);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "ast.hpp"
+
+// AST-level constant folding and simplification, run between parsing and IR
+// emission: folds NumberExpr arithmetic, drops unary +, and collapses
+// if/while with constant conditions. Machine-generated inputs are dense
+// with constant subexpressions, so this shrinks the emitted module (and
+// everything downstream) substantially. Rewrites in place; replacement
+// nodes go into the unit's arena.
+void foldTranslationUnit(TranslationUnit &tu);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Dense identifier id. Symbols are hash-consed once at lex time; everything
+// downstream (AST names, symbol tables) carries and compares the 32-bit id
+// instead of string bytes.
+using Symbol = std::uint32_t;
+
+// Hash-consing interner: open-addressing table over string_view slices of
+// the source buffer (which outlives the compilation, see Lexer). Interning
+// the same spelling twice returns the same dense id, so a vector indexed by
+// Symbol is a perfect-hash symbol table.
+class Interner {
+public:
+  Interner() : slots(kInitialSlots) {}
+
+  Symbol intern(std::string_view text) {
+    std::uint64_t h = hash(text);
+    std::size_t mask = slots.size() - 1;
+    std::size_t i = static_cast<std::size_t>(h) & mask;
+    for (;;) {
+      Slot &slot = slots[i];
+      if (!slot.used) {
+        if ((spellings.size() + 1) * 10 > slots.size() * 7) {
+          grow();
+          return intern(text); // table moved; reprobe
+        }
+        slot.used = true;
+        slot.hash = h;
+        slot.sym = static_cast<Symbol>(spellings.size());
+        spellings.push_back(text);
+        return slot.sym;
+      }
+      if (slot.hash == h && spellings[slot.sym] == text) return slot.sym;
+      i = (i + 1) & mask;
+    }
+  }
+
+  std::string_view spelling(Symbol sym) const { return spellings[sym]; }
+
+  // Forget all symbols but keep table and vector capacity. Spellings are
+  // views into a source buffer, so a pooled interner must be reset before
+  // the next file's buffer replaces the old one.
+  void reset() {
+    std::fill(slots.begin(), slots.end(), Slot{});
+    spellings.clear();
+  }
+
+  // Number of distinct symbols; also one past the largest id handed out.
+  std::size_t size() const { return spellings.size(); }
+
+private:
+  struct Slot {
+    std::uint64_t hash{0};
+    Symbol sym{0};
+    bool used{false};
+  };
+
+  static constexpr std::size_t kInitialSlots = 1u << 10;
+
+  static std::uint64_t hash(std::string_view text) {
+    // FNV-1a
+    std::uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : text) {
+      h ^= c;
+      h *= 1099511628211ull;
+    }
+    return h;
+  }
+
+  void grow() {
+    std::vector<Slot> bigger(slots.size() * 2);
+    std::size_t mask = bigger.size() - 1;
+    for (const Slot &slot : slots) {
+      if (!slot.used) continue;
+      std::size_t i = static_cast<std::size_t>(slot.hash) & mask;
+      while (bigger[i].used) i = (i + 1) & mask;
+      bigger[i] = slot;
+    }
+    slots = std::move(bigger);
+  }
+
+  std::vector<Slot> slots;
+  std::vector<std::string_view> spellings;
+};
@@ -1,45 +1,134 @@
 #include "lexer.hpp"
-#include <cctype>
+#include <charconv>
+#include <string>
 #include <stdexcept>
 
-Lexer::Lexer(const std::string &source) : source(source) {}
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-const Token &Lexer::peek() {
-  if (!hasCurrent) {
-    current = readToken();
-    hasCurrent = true;
+// Table-driven character classification: one cache-resident lookup instead
+// of a locale-aware std::isalpha/std::isdigit call per character.
+namespace {
+
+enum : unsigned char {
+  CharSpace = 1 << 0,    // ' ' '\t' '\r'
+  CharDigit = 1 << 1,    // 0-9
+  CharIdentStart = 1 << 2, // A-Z a-z _
+};
+
+constexpr unsigned char classOf(unsigned char c) {
+  return (c == ' ' || c == '\t' || c == '\r' ? CharSpace : 0) |
+         (c >= '0' && c <= '9' ? CharDigit : 0) |
+         ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' ? CharIdentStart : 0);
+}
+
+struct CharTable {
+  unsigned char cls[256]{};
+  constexpr CharTable() {
+    for (unsigned i = 0; i < 256; ++i) cls[i] = classOf(static_cast<unsigned char>(i));
+  }
+};
+
+constexpr CharTable charTable{};
+
+inline bool isSpaceChar(char c) { return charTable.cls[static_cast<unsigned char>(c)] & CharSpace; }
+inline bool isDigitChar(char c) { return charTable.cls[static_cast<unsigned char>(c)] & CharDigit; }
+inline bool isIdentStartChar(char c) { return charTable.cls[static_cast<unsigned char>(c)] & CharIdentStart; }
+inline bool isIdentChar(char c) {
+  return charTable.cls[static_cast<unsigned char>(c)] & (CharIdentStart | CharDigit);
+}
+
+// Length-switched keyword automaton over the raw source span: one switch
+// on the span length, then a first-character dispatch and a single
+// constant-length comparison -- no string construction and at most one
+// memcmp per identifier, instead of six sequential compares.
+TokenKind keywordKind(std::string_view text) {
+  switch (text.size()) {
+  case 2:
+    if (text[0] == 'i' && text[1] == 'f') return TokenKind::KwIf;
+    break;
+  case 3:
+    if (text == "int") return TokenKind::KwInt;
+    break;
+  case 4:
+    if (text == "else") return TokenKind::KwElse;
+    break;
+  case 5:
+    if (text == "while") return TokenKind::KwWhile;
+    break;
+  case 6:
+    if (text[0] == 'r') {
+      if (text == "return") return TokenKind::KwReturn;
+    } else if (text[0] == 'e') {
+      if (text == "extern") return TokenKind::KwExtern;
+    }
+    break;
+  default:
+    break;
+  }
+  return TokenKind::Identifier;
+}
+
+} // namespace
+
+Lexer::Lexer(std::string_view source, Interner &interner, DiagnosticEngine *diags)
+    : source(source), interner(interner), diags(diags) {}
+
+void Lexer::lexAll(std::vector<Token> &out) {
+  out.clear();
+  // Identifier-dense sources run around 4-5 bytes per token; reserving for
+  // that keeps the growth path out of the scan loop.
+  out.reserve(source.size() / 4 + 16);
+  for (;;) {
+    out.push_back(readToken());
+    if (out.back().kind == TokenKind::Eof) break;
   }
-  return current;
 }
 
-Token Lexer::next() {
-  const Token &t = peek();
-  hasCurrent = false;
-  return t;
+std::vector<Token> Lexer::lexAll() {
+  std::vector<Token> tokens;
+  lexAll(tokens);
+  return tokens;
 }
 
 bool Lexer::atEnd() const { return index >= source.size(); }
 
 void Lexer::skipWhitespaceAndComments() {
+  // No line/column bookkeeping anywhere in this loop: tokens carry byte
+  // offsets and only diagnostics ever resolve them (LineMap, on demand).
   while (!atEnd()) {
     char c = source[index];
-    if (c == ' ' || c == '\t' || c == '\r') { index++; column++; continue; }
-    if (c == '\n') { index++; line++; column = 1; continue; }
+    if (c == ' ') {
+#if defined(__SSE2__)
+      // Generated sources are indentation-heavy: chew through whole
+      // 16-byte blocks of plain spaces before falling back to the scalar
+      // loop.
+      const __m128i spaces = _mm_set1_epi8(' ');
+      while (index + 16 <= source.size()) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source.data() + index));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(block, spaces)) != 0xFFFF) break;
+        index += 16;
+      }
+      if (atEnd() || source[index] != ' ') continue;
+#endif
+      index++; continue;
+    }
+    if (isSpaceChar(c) || c == '\n') { index++; continue; }
     // // comment
     if (c == '/' && index + 1 < source.size() && source[index+1] == '/') {
-      index += 2; column += 2;
-      while (!atEnd() && source[index] != '\n') { index++; column++; }
+      index += 2;
+      while (!atEnd() && source[index] != '\n') index++;
       continue;
     }
     // /* block comment */
     if (c == '/' && index + 1 < source.size() && source[index+1] == '*') {
-      index += 2; column += 2;
+      index += 2;
       while (!atEnd()) {
         if (source[index] == '*' && index + 1 < source.size() && source[index+1] == '/') {
-          index += 2; column += 2; break;
+          index += 2; break;
         }
-        if (source[index] == '\n') { line++; column = 1; index++; continue; }
-        index++; column++;
+        index++;
       }
       continue;
     }
@@ -47,78 +136,84 @@ void Lexer::skipWhitespaceAndComments() {
   }
 }
 
-Token Lexer::makeToken(TokenKind kind, const std::string &lexeme, std::int64_t intValue) {
-  Token t; t.kind = kind; t.lexeme = lexeme; t.intValue = intValue; t.line = line; t.column = column; return t;
+Token Lexer::makeToken(TokenKind kind, std::string_view lexeme, std::size_t offset,
+                       std::int64_t intValue) {
+  Token t; t.kind = kind; t.lexeme = lexeme; t.intValue = intValue; t.offset = offset; return t;
 }
 
 Token Lexer::readToken() {
+  // One iteration per recovered scan error: an unexpected character is
+  // recorded, skipped, and the loop scans on. Iteration, not recursion --
+  // a megabyte of garbage must not grow the call stack.
+  for (;;) {
   skipWhitespaceAndComments();
-  if (atEnd()) return makeToken(TokenKind::Eof, "");
+  if (atEnd()) return makeToken(TokenKind::Eof, {}, source.size());
 
   char c = source[index];
 
   // Identifiers/keywords
-  if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
-    std::size_t start = index; std::size_t startCol = column;
-    index++; column++;
-    while (!atEnd()) {
-      char d = source[index];
-      if (std::isalnum(static_cast<unsigned char>(d)) || d == '_') { index++; column++; }
-      else break;
-    }
-    std::string text = source.substr(start, index - start);
-    if (text == "int") return Token{TokenKind::KwInt, text, 0, line, startCol};
-    if (text == "return") return Token{TokenKind::KwReturn, text, 0, line, startCol};
-    if (text == "if") return Token{TokenKind::KwIf, text, 0, line, startCol};
-    if (text == "else") return Token{TokenKind::KwElse, text, 0, line, startCol};
-    if (text == "while") return Token{TokenKind::KwWhile, text, 0, line, startCol};
-    if (text == "extern") return Token{TokenKind::KwExtern, text, 0, line, startCol};
-    return Token{TokenKind::Identifier, text, 0, line, startCol};
+  if (isIdentStartChar(c)) {
+    std::size_t start = index;
+    index++;
+    while (!atEnd() && isIdentChar(source[index])) index++;
+    std::string_view text = source.substr(start, index - start);
+    TokenKind kind = keywordKind(text);
+    if (kind != TokenKind::Identifier) return Token{kind, text, 0, 0, start};
+    return Token{TokenKind::Identifier, text, 0, interner.intern(text), start};
   }
 
   // Numbers (decimal integers only)
-  if (std::isdigit(static_cast<unsigned char>(c))) {
-    std::size_t start = index; std::size_t startCol = column;
-    while (!atEnd() && std::isdigit(static_cast<unsigned char>(source[index]))) { index++; column++; }
-    std::string text = source.substr(start, index - start);
-    long long value = std::stoll(text);
-    return Token{TokenKind::Number, text, value, line, startCol};
-  }
-
-  auto two = [&](char a, char b, TokenKind kind){
-    if (!atEnd() && index + 1 < source.size() && source[index] == a && source[index+1] == b) {
-      std::size_t startCol = column; index += 2; column += 2; return Token{kind, std::string({a,b}), 0, line, startCol};
+  if (isDigitChar(c)) {
+    std::size_t start = index;
+    while (!atEnd() && isDigitChar(source[index])) index++;
+    std::string_view text = source.substr(start, index - start);
+    long long value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc()) {
+      if (!diags) throw std::runtime_error("Integer literal out of range: " + std::string(text));
+      diags->error(start, "Integer literal out of range: " + std::string(text));
+      value = 0;
     }
-    return Token{TokenKind::Eof, "", 0, line, column};
-  };
+    return Token{TokenKind::Number, text, value, 0, start};
+  }
 
   // Two-char operators
-  if (c == '=' && index + 1 < source.size() && source[index+1] == '=') { std::size_t sc = column; index += 2; column += 2; return Token{TokenKind::Eq, "==", 0, line, sc}; }
-  if (c == '!' && index + 1 < source.size() && source[index+1] == '=') { std::size_t sc = column; index += 2; column += 2; return Token{TokenKind::Ne, "!=", 0, line, sc}; }
-  if (c == '<' && index + 1 < source.size() && source[index+1] == '=') { std::size_t sc = column; index += 2; column += 2; return Token{TokenKind::Le, "<=", 0, line, sc}; }
-  if (c == '>' && index + 1 < source.size() && source[index+1] == '=') { std::size_t sc = column; index += 2; column += 2; return Token{TokenKind::Ge, ">=", 0, line, sc}; }
-  if (c == '&' && index + 1 < source.size() && source[index+1] == '&') { std::size_t sc = column; index += 2; column += 2; return Token{TokenKind::AndAnd, "&&", 0, line, sc}; }
-  if (c == '|' && index + 1 < source.size() && source[index+1] == '|') { std::size_t sc = column; index += 2; column += 2; return Token{TokenKind::OrOr, "||", 0, line, sc}; }
+  if (c == '=' && index + 1 < source.size() && source[index+1] == '=') { std::size_t start = index; std::string_view text = source.substr(index, 2); index += 2; return Token{TokenKind::Eq, text, 0, 0, start}; }
+  if (c == '!' && index + 1 < source.size() && source[index+1] == '=') { std::size_t start = index; std::string_view text = source.substr(index, 2); index += 2; return Token{TokenKind::Ne, text, 0, 0, start}; }
+  if (c == '<' && index + 1 < source.size() && source[index+1] == '=') { std::size_t start = index; std::string_view text = source.substr(index, 2); index += 2; return Token{TokenKind::Le, text, 0, 0, start}; }
+  if (c == '>' && index + 1 < source.size() && source[index+1] == '=') { std::size_t start = index; std::string_view text = source.substr(index, 2); index += 2; return Token{TokenKind::Ge, text, 0, 0, start}; }
+  if (c == '<' && index + 1 < source.size() && source[index+1] == '<') { std::size_t start = index; std::string_view text = source.substr(index, 2); index += 2; return Token{TokenKind::Shl, text, 0, 0, start}; }
+  if (c == '>' && index + 1 < source.size() && source[index+1] == '>') { std::size_t start = index; std::string_view text = source.substr(index, 2); index += 2; return Token{TokenKind::Shr, text, 0, 0, start}; }
+  if (c == '&' && index + 1 < source.size() && source[index+1] == '&') { std::size_t start = index; std::string_view text = source.substr(index, 2); index += 2; return Token{TokenKind::AndAnd, text, 0, 0, start}; }
+  if (c == '|' && index + 1 < source.size() && source[index+1] == '|') { std::size_t start = index; std::string_view text = source.substr(index, 2); index += 2; return Token{TokenKind::OrOr, text, 0, 0, start}; }
 
   // Single-char tokens
-  index++; column++;
+  std::size_t start = index;
+  std::string_view text = source.substr(index, 1);
+  index++;
   switch (c) {
-    case '(': return makeToken(TokenKind::LParen, "(");
-    case ')': return makeToken(TokenKind::RParen, ")");
-    case '{': return makeToken(TokenKind::LBrace, "{");
-    case '}': return makeToken(TokenKind::RBrace, "}");
-    case ',': return makeToken(TokenKind::Comma, ",");
-    case ';': return makeToken(TokenKind::Semicolon, ";");
-    case '+': return makeToken(TokenKind::Plus, "+");
-    case '-': return makeToken(TokenKind::Minus, "-");
-    case '*': return makeToken(TokenKind::Star, "*");
-    case '/': return makeToken(TokenKind::Slash, "/");
-    case '%': return makeToken(TokenKind::Percent, "%");
-    case '=': return makeToken(TokenKind::Assign, "=");
-    case '<': return makeToken(TokenKind::Lt, "<");
-    case '>': return makeToken(TokenKind::Gt, ">");
-    case '!': return makeToken(TokenKind::Not, "!");
+    case '(': return makeToken(TokenKind::LParen, text, start);
+    case ')': return makeToken(TokenKind::RParen, text, start);
+    case '{': return makeToken(TokenKind::LBrace, text, start);
+    case '}': return makeToken(TokenKind::RBrace, text, start);
+    case ',': return makeToken(TokenKind::Comma, text, start);
+    case ';': return makeToken(TokenKind::Semicolon, text, start);
+    case '+': return makeToken(TokenKind::Plus, text, start);
+    case '-': return makeToken(TokenKind::Minus, text, start);
+    case '*': return makeToken(TokenKind::Star, text, start);
+    case '/': return makeToken(TokenKind::Slash, text, start);
+    case '%': return makeToken(TokenKind::Percent, text, start);
+    case '=': return makeToken(TokenKind::Assign, text, start);
+    case '<': return makeToken(TokenKind::Lt, text, start);
+    case '>': return makeToken(TokenKind::Gt, text, start);
+    case '!': return makeToken(TokenKind::Not, text, start);
+    case '&': return makeToken(TokenKind::Amp, text, start);
+    case '|': return makeToken(TokenKind::Pipe, text, start);
+    case '^': return makeToken(TokenKind::Caret, text, start);
   }
 
-  throw std::runtime_error("Unexpected character: " + std::string(1, c));
+  if (!diags) throw std::runtime_error("Unexpected character: " + std::string(1, c));
+  // Already consumed above; report and scan on from the next character.
+  diags->error(start, "Unexpected character: " + std::string(1, c));
+  }
 }
@@ -1,30 +1,35 @@
 #pragma once
 
+#include "diag.hpp"
 #include "token.hpp"
-#include <string>
+#include <string_view>
+#include <vector>
 
 class Lexer {
 public:
-  explicit Lexer(const std::string &source);
-
-  // Look at current token without consuming
-  const Token &peek();
-
-  // Consume and return current token
-  Token next();
+  // The source buffer must outlive the Lexer and every Token it produces;
+  // lexemes are string_view slices into it. Identifiers are interned into
+  // `interner` as they are scanned. With a diagnostic engine attached, scan
+  // errors are recorded and skipped instead of thrown.
+  Lexer(std::string_view source, Interner &interner, DiagnosticEngine *diags = nullptr);
+
+  // Scan the whole source into one contiguous token array (terminated by
+  // an Eof token). Parsing then indexes the array instead of interleaving
+  // with the scanner, and a driver can lex file N+1 while file N parses.
+  // The out-param form appends into a pooled buffer (cleared first).
+  void lexAll(std::vector<Token> &out);
+  std::vector<Token> lexAll();
 
   bool atEnd() const;
 
 private:
-  std::string source;
+  std::string_view source;
+  Interner &interner;
+  DiagnosticEngine *diags{nullptr};
   std::size_t index{0};
-  std::size_t line{1};
-  std::size_t column{1};
-
-  Token current{};
-  bool hasCurrent{false};
 
   void skipWhitespaceAndComments();
   Token readToken();
-  Token makeToken(TokenKind kind, const std::string &lexeme, std::int64_t intValue = 0);
+  Token makeToken(TokenKind kind, std::string_view lexeme, std::size_t offset,
+                  std::int64_t intValue = 0);
 };
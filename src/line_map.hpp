@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Offset -> line/column index, built on demand: successful compiles never
+// pay for location bookkeeping, and the first diagnostic amortizes one
+// linear scan for newlines over every message that follows.
+class LineMap {
+public:
+  explicit LineMap(std::string_view source) {
+    lineStarts.push_back(0);
+    for (std::size_t i = 0; i < source.size(); ++i) {
+      if (source[i] == '\n') lineStarts.push_back(i + 1);
+    }
+  }
+
+  struct LineCol {
+    std::size_t line;   // 1-based
+    std::size_t column; // 1-based
+  };
+
+  LineCol locate(std::size_t offset) const {
+    auto it = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+    std::size_t lineIndex = static_cast<std::size_t>(it - lineStarts.begin()) - 1;
+    return LineCol{lineIndex + 1, offset - lineStarts[lineIndex] + 1};
+  }
+
+private:
+  std::vector<std::size_t> lineStarts;
+};
@@ -1,30 +1,345 @@
-#include "lexer.hpp"
-#include "parser.hpp"
-#include "codegen.hpp"
+#include "cache.hpp"
+#include "compile_session.hpp"
+#include "prelude.hpp"
+#include "source_buffer.hpp"
 
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The CLI is a thin client of the CompileSession library API: it owns file
+// I/O, the on-disk caches and the job scheduling; the sessions own the
+// compiler state (one session per thread, reused across files).
+
+enum class StatsMode { None, Text, Json };
+
+namespace {
+
+struct DriverConfig {
+  CompileOptions session;
+  OutputKind emit{OutputKind::IR};
+  StatsMode statsMode{StatsMode::None};
+  const CompileCache *cache{nullptr};
+  const PreludeCache *prelude{nullptr};
+};
+
+std::string baseName(const std::string &path) {
+  std::size_t slash = path.find_last_of('/');
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// Default output name: input with its .c swapped for the emission suffix
+// (foo.c -> foo.ll / foo.bc / foo.o). With an output directory, the result
+// lands there under the input's basename.
+std::string defaultOutputPath(const std::string &inputPath, OutputKind kind,
+                              const std::string &outDir = {}) {
+  std::string base = outDir.empty() ? inputPath : outDir + "/" + baseName(inputPath);
+  if (base.size() > 2 && base.compare(base.size() - 2, 2, ".c") == 0)
+    base.erase(base.size() - 2);
+  switch (kind) {
+  case OutputKind::IR: return base + ".ll";
+  case OutputKind::Bitcode: return base + ".bc";
+  case OutputKind::Object: return base + ".o";
+  }
+  return base;
+}
+
+// Everything besides the source bytes that shapes the output; part of the
+// cache key so stale entries can't be replayed across flag or version
+// changes.
+std::string cacheFingerprint(const DriverConfig &config) {
+  const CompileOptions &o = config.session;
+  std::string fp = "ccl1;emit=";
+  fp += config.emit == OutputKind::IR ? "ll" : config.emit == OutputKind::Bitcode ? "bc" : "o";
+  fp += ";fold=" + std::to_string(o.fold);
+  fp += ";sc=" + std::to_string(o.shortCircuit);
+  fp += ";O=" + std::to_string(o.optLevel);
+  fp += ";all=" + std::to_string(o.emitAll);
+  // --jobs shapes IR bytes too (per-shard optimization, no cross-shard
+  // inlining), so sharded and serial outputs must not alias. Normalized so
+  // every serial spelling (-j 1, default) shares one entry.
+  if (config.emit == OutputKind::IR) fp += ";jobs=" + std::to_string(o.jobs < 2 ? 1 : o.jobs);
+  if (config.prelude) fp += ";prelude=" + config.prelude->hash();
+  return fp;
+}
+
+void printStats(const CompileSession &session, StatsMode mode) {
+  if (mode == StatsMode::Text) session.lastStats().report(std::cerr);
+  else if (mode == StatsMode::Json) session.lastStats().reportJson(std::cerr);
+}
+
+void writeFileOrThrow(const std::string &outPath, std::string_view bytes) {
+  std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+  if (!out) throw std::runtime_error("could not write output: " + outPath);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  out.flush();
+  if (!out) throw std::runtime_error("could not write output: " + outPath);
+}
+
+// One compilation through the session, streamed to `outPath` (or stdout
+// when empty, IR mode only). With the cache enabled the bytes have to be
+// materialized anyway (to store them); without it the output flows through
+// a buffered raw_fd_ostream incrementally, so a hundreds-of-MB module never
+// doubles peak RSS at the end of the compile.
+void compileToPath(const std::string &path, CompileSession &session, const DriverConfig &config,
+                   const std::string &outPath) {
+  SourceBuffer source = SourceBuffer::open(path);
+
+  std::string key;
+  if (config.cache) {
+    key = CompileCache::key(source.view(), cacheFingerprint(config));
+    std::string cached;
+    if (!config.cache->load(key, cached)) {
+      try {
+        switch (config.emit) {
+        case OutputKind::IR: cached = session.compileIR(source.view()); break;
+        case OutputKind::Bitcode: cached = session.compileBitcode(source.view()); break;
+        case OutputKind::Object: cached = session.compileObject(source.view()); break;
+        }
+      } catch (const std::exception &) {
+        session.reportDiagnostics(std::cerr, path, source.view());
+        throw;
+      }
+      printStats(session, config.statsMode);
+      config.cache->store(key, cached);
+    }
+    if (outPath.empty()) {
+      std::cout << cached << std::endl;
+    } else {
+      writeFileOrThrow(outPath, cached);
+    }
+    return;
+  }
+
+  std::error_code ec;
+  llvm::raw_fd_ostream out(outPath.empty() ? "-" : outPath, ec, llvm::sys::fs::OF_None);
+  if (ec) throw std::runtime_error("could not write output: " + outPath + ": " + ec.message());
+  try {
+    session.compileTo(source.view(), config.emit, out);
+  } catch (const std::exception &) {
+    session.reportDiagnostics(std::cerr, path, source.view());
+    // Don't leave a truncated artifact behind (it may have clobbered a
+    // previous good output).
+    if (!outPath.empty()) {
+      out.close();
+      std::remove(outPath.c_str());
+    }
+    throw;
+  }
+  if (outPath.empty()) out << "\n"; // match the old std::endl on stdout
+  out.flush();
+  if (out.has_error()) throw std::runtime_error("could not write output: " + outPath);
+  printStats(session, config.statsMode);
+}
+
+// Multi-file mode: a pool of driver threads pulls inputs off a shared
+// queue, so reading, lexing/parsing and codegen of different files overlap
+// and LLVM initialization is paid once. Each worker keeps one session for
+// its lifetime. Status goes to stdout per file, like server mode.
+int compileMany(const std::vector<std::string> &inputs, unsigned poolSize,
+                const DriverConfig &config, const std::string &outDir) {
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> anyFailed{false};
+  std::mutex outputLock;
+
+  auto worker = [&] {
+    CompileSession session(config.session);
+    session.setPrelude(config.prelude);
+    for (;;) {
+      std::size_t i = next.fetch_add(1);
+      if (i >= inputs.size()) return;
+      const std::string &path = inputs[i];
+      try {
+        std::string outPath = defaultOutputPath(path, config.emit, outDir);
+        compileToPath(path, session, config, outPath);
+        std::lock_guard<std::mutex> lock(outputLock);
+        std::cout << "ok " << outPath << std::endl;
+      } catch (const std::exception &ex) {
+        anyFailed = true;
+        std::lock_guard<std::mutex> lock(outputLock);
+        std::cout << "error " << path << ": " << ex.what() << std::endl;
+      }
+    }
+  };
+
+  if (poolSize > inputs.size()) poolSize = static_cast<unsigned>(inputs.size());
+  if (poolSize < 1) poolSize = 1;
+  std::vector<std::thread> pool;
+  pool.reserve(poolSize);
+  for (unsigned w = 0; w < poolSize; ++w) pool.emplace_back(worker);
+  for (auto &t : pool) t.join();
+  return anyFailed ? 1 : 0;
+}
+
+// Server mode: a long-lived process that compiles a stream of jobs, paying
+// process spawn and LLVM initialization once per farm run instead of once
+// per file. Protocol: one source path per line on stdin; each compile
+// writes <input>.ll (or .bc/.o under -emit-bc/-c) next to the input and
+// answers "ok <output>" or "error <path>: <message>" on stdout. EOF shuts
+// the server down. A client is any program that can write paths to a pipe.
+int runServer(const DriverConfig &config) {
+  CompileSession session(config.session);
+  session.setPrelude(config.prelude);
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (line.empty()) continue;
+    try {
+      std::string outPath =
+          config.emit == OutputKind::IR ? line + ".ll" : defaultOutputPath(line, config.emit);
+      compileToPath(line, session, config, outPath);
+      std::cout << "ok " << outPath << std::endl;
+    } catch (const std::exception &ex) {
+      std::cout << "error " << line << ": " << ex.what() << std::endl;
+    }
+  }
+  return 0;
+}
+
+} // namespace
 
 int main(int argc, char **argv) {
-  if (argc < 2) {
-    std::cerr << "usage: ccl <file.c>\n";
+  DriverConfig config;
+  bool server = false;
+  bool runJit = false;
+  std::vector<std::string> inputPaths;
+  std::string outputPath;
+  std::string cacheDir;
+  std::string preludePath;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--server") {
+      server = true;
+    } else if (arg == "--run") {
+      runJit = true;
+    } else if (arg == "-emit-bc") {
+      config.emit = OutputKind::Bitcode;
+    } else if (arg == "-c") {
+      config.emit = OutputKind::Object;
+    } else if (arg == "-o") {
+      if (i + 1 >= argc) { std::cerr << "error: -o requires a value\n"; return 1; }
+      outputPath = argv[++i];
+    } else if (arg == "-O0" || arg == "-O1" || arg == "-O2") {
+      config.session.optLevel = static_cast<unsigned>(arg[2] - '0');
+    } else if (arg == "-ftime-report") {
+      config.statsMode = StatsMode::Text;
+    } else if (arg == "--stats-json") {
+      config.statsMode = StatsMode::Json;
+    } else if (arg == "-fno-fold") {
+      config.session.fold = false;
+    } else if (arg == "-fno-short-circuit") {
+      config.session.shortCircuit = false;
+    } else if (arg == "--emit-all") {
+      config.session.emitAll = true;
+    } else if (arg.rfind("--verify=", 0) == 0) {
+      std::string mode = arg.substr(9);
+      if (mode == "none") config.session.verify = VerifyMode::None;
+      else if (mode == "module") config.session.verify = VerifyMode::Module;
+      else if (mode == "full") config.session.verify = VerifyMode::Full;
+      else { std::cerr << "error: invalid --verify mode: " << mode << "\n"; return 1; }
+    } else if (arg == "--prelude") {
+      if (i + 1 >= argc) { std::cerr << "error: --prelude requires a value\n"; return 1; }
+      preludePath = argv[++i];
+    } else if (arg == "--cache-dir") {
+      if (i + 1 >= argc) { std::cerr << "error: --cache-dir requires a value\n"; return 1; }
+      cacheDir = argv[++i];
+    } else if (arg == "--jobs" || arg == "-j") {
+      if (i + 1 >= argc) { std::cerr << "error: " << arg << " requires a value\n"; return 1; }
+      char *end = nullptr;
+      long n = std::strtol(argv[++i], &end, 10);
+      if (n < 1 || !end || *end != '\0') { std::cerr << "error: invalid job count\n"; return 1; }
+      config.session.jobs = static_cast<unsigned>(n);
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      std::cerr << "error: unknown option: " << arg << "\n";
+      return 1;
+    } else {
+      inputPaths.push_back(arg);
+    }
+  }
+
+  std::unique_ptr<CompileCache> cache;
+  std::unique_ptr<PreludeCache> prelude;
+  try {
+    if (!cacheDir.empty()) cache = std::make_unique<CompileCache>(cacheDir);
+    if (!preludePath.empty())
+      prelude = std::make_unique<PreludeCache>(PreludeCache::load(preludePath));
+  } catch (const std::exception &ex) {
+    std::cerr << "error: " << ex.what() << "\n";
+    return 1;
+  }
+  config.cache = cache.get();
+  config.prelude = prelude.get();
+
+  if (server) {
+    if (!inputPaths.empty()) { std::cerr << "error: --server takes no input file\n"; return 1; }
+    return runServer(config);
+  }
+
+  if (inputPaths.empty()) {
+    std::cerr << "usage: ccl [--jobs N] [-O0|-O1|-O2] [-emit-bc | -c] [-o out] <file.c>... | "
+                 "ccl --server\n";
+    return 1;
+  }
+
+  if (runJit && inputPaths.size() != 1) {
+    std::cerr << "error: --run takes exactly one input file\n";
     return 1;
   }
 
-  std::ifstream in(argv[1]);
-  if (!in) { std::cerr << "could not open file\n"; return 1; }
-  std::stringstream buffer; buffer << in.rdbuf();
-  std::string source = buffer.str();
+  if (inputPaths.size() > 1) {
+    // Multiple inputs: -o names an output directory (outputs keep their
+    // input basenames); without it, outputs land next to their inputs.
+    // The --jobs budget drives the file-level pool; each file compiles
+    // serially inside its worker.
+    unsigned poolSize = config.session.jobs;
+    DriverConfig manyConfig = config;
+    manyConfig.session.jobs = 1;
+    return compileMany(inputPaths, poolSize, manyConfig, outputPath);
+  }
 
+  const std::string &inputPath = inputPaths.front();
   try {
-    Lexer lex(source);
-    Parser parser(lex);
-    auto tu = parser.parseTranslationUnit();
+    CompileSession session(config.session);
+    session.setPrelude(config.prelude);
+
+    if (runJit) {
+      SourceBuffer source = SourceBuffer::open(inputPath);
+      int rc;
+      try {
+        rc = session.runMain(source.view());
+      } catch (const std::exception &) {
+        session.reportDiagnostics(std::cerr, inputPath, source.view());
+        throw;
+      }
+      printStats(session, config.statsMode);
+      return rc;
+    }
 
-    CodeGen cg("module");
-    std::string ir = cg.emitIR(*tu);
-    std::cout << ir << std::endl;
+    if (config.emit == OutputKind::IR) {
+      if (outputPath.empty() || outputPath == "-") {
+        compileToPath(inputPath, session, config, "");
+      } else {
+        compileToPath(inputPath, session, config, outputPath);
+      }
+    } else {
+      if (inputPath == "-" && outputPath.empty()) {
+        std::cerr << "error: -o is required when reading stdin\n";
+        return 1;
+      }
+      std::string outPath =
+          outputPath.empty() ? defaultOutputPath(inputPath, config.emit) : outputPath;
+      compileToPath(inputPath, session, config, outPath);
+    }
   } catch (const std::exception &ex) {
     std::cerr << "error: " << ex.what() << "\n";
     return 1;
@@ -1,17 +1,46 @@
 #include "parser.hpp"
 #include <stdexcept>
 
-Parser::Parser(Lexer lexer) : lexer(std::move(lexer)) {}
+Parser::Parser(Lexer lexer, CompileStats *stats, DiagnosticEngine *diags)
+    : Parser(lexer.lexAll(), stats, diags) {}
 
-const Token &Parser::peek() {
-  if (!hasLookahead) { lookahead = this->lexer.peek(); hasLookahead = true; }
-  return lookahead;
+Parser::Parser(std::vector<Token> tokens, CompileStats *stats, DiagnosticEngine *diags)
+    : tokens(std::move(tokens)), stats(stats ? stats : &CompileStats::discard()), diags(diags) {}
+
+void Parser::errorHere(const std::string &message) { errorAt(peek(), message); }
+
+void Parser::errorAt(const Token &token, const std::string &message) {
+  if (!diags) throw std::runtime_error(message);
+  diags->error(token.offset, message);
+  throw RecoveryUnwind{};
+}
+
+// Skip to the end of the broken statement: past the next ';', or stop just
+// before '}' / Eof so the enclosing block can continue.
+void Parser::synchronizeStatement() {
+  parenDepth = 0; // RecoveryUnwind skips the decrements in parsePrimary
+  while (peek().kind != TokenKind::Eof && peek().kind != TokenKind::RBrace) {
+    if (consume().kind == TokenKind::Semicolon) return;
+  }
 }
 
+// Skip to something that can start a top-level declaration.
+void Parser::synchronizeTopLevel() {
+  parenDepth = 0;
+  while (peek().kind != TokenKind::Eof && peek().kind != TokenKind::KwInt &&
+         peek().kind != TokenKind::KwExtern) {
+    consume();
+  }
+}
+
+const Token &Parser::peek() { return tokens[pos]; }
+
 Token Parser::consume() {
-  const Token &t = peek();
-  hasLookahead = false;
-  return this->lexer.next();
+  const Token &t = tokens[pos];
+  // The array is Eof-terminated; stay parked on it like the streaming
+  // lexer used to.
+  if (t.kind != TokenKind::Eof) pos++;
+  return t;
 }
 
 bool Parser::match(TokenKind kind) {
@@ -20,55 +49,69 @@ bool Parser::match(TokenKind kind) {
 }
 
 void Parser::expect(TokenKind kind, const char *what) {
-  if (!match(kind)) throw std::runtime_error(std::string("Expected ") + what);
+  if (!match(kind)) errorHere(std::string("Expected ") + what);
 }
 
 std::unique_ptr<TranslationUnit> Parser::parseTranslationUnit() {
   auto tu = std::make_unique<TranslationUnit>();
+  parseInto(*tu);
+  return tu;
+}
+
+void Parser::parseInto(TranslationUnit &tu) {
+  arena = &tu.arena;
+  parenDepth = 0;
   while (true) {
     if (peek().kind == TokenKind::Eof) break;
-    if (peek().kind == TokenKind::KwExtern) {
-      tu->externs.push_back(parseExtern());
-    } else {
-      tu->functions.push_back(parseFunction());
+    try {
+      if (peek().kind == TokenKind::KwExtern) {
+        tu.externs.push_back(parseExtern());
+      } else {
+        tu.functions.push_back(parseFunction());
+      }
+    } catch (RecoveryUnwind) {
+      synchronizeTopLevel();
     }
   }
-  return tu;
 }
 
-std::unique_ptr<ExternDecl> Parser::parseExtern() {
+ExternDecl *Parser::parseExtern() {
   expect(TokenKind::KwExtern, "extern");
   expect(TokenKind::KwInt, "int");
   Token nameTok = consume();
-  if (nameTok.kind != TokenKind::Identifier) throw std::runtime_error("Expected function name");
+  if (nameTok.kind != TokenKind::Identifier) errorHere("Expected function name");
   expect(TokenKind::LParen, "(");
   auto params = parseParamList();
   expect(TokenKind::RParen, ")");
   expect(TokenKind::Semicolon, ";");
-  auto e = std::make_unique<ExternDecl>();
-  e->name = nameTok.lexeme; e->params = std::move(params);
+  auto *e = arena->create<ExternDecl>();
+  e->name = nameTok.symbol; e->params = std::move(params);
   return e;
 }
 
-std::unique_ptr<Function> Parser::parseFunction() {
+Function *Parser::parseFunction() {
   expect(TokenKind::KwInt, "int");
   Token nameTok = consume();
-  if (nameTok.kind != TokenKind::Identifier) throw std::runtime_error("Expected function name");
+  if (nameTok.kind != TokenKind::Identifier) errorHere("Expected function name");
   expect(TokenKind::LParen, "(");
   auto params = parseParamList();
   expect(TokenKind::RParen, ")");
   expect(TokenKind::LBrace, "{");
   auto body = parseBlock();
   expect(TokenKind::RBrace, "}");
-  auto f = std::make_unique<Function>();
-  f->name = nameTok.lexeme; f->params = std::move(params); f->body = std::move(body);
+  auto *f = arena->create<Function>();
+  f->name = nameTok.symbol; f->params = std::move(params); f->body = std::move(body);
   return f;
 }
 
-std::vector<StmtPtr> Parser::parseBlock() {
-  std::vector<StmtPtr> stmts;
-  while (peek().kind != TokenKind::RBrace) {
-    stmts.push_back(parseStatement());
+StmtList Parser::parseBlock() {
+  StmtList stmts;
+  while (peek().kind != TokenKind::RBrace && peek().kind != TokenKind::Eof) {
+    try {
+      stmts.push_back(parseStatement());
+    } catch (RecoveryUnwind) {
+      synchronizeStatement();
+    }
   }
   return stmts;
 }
@@ -87,7 +130,7 @@ StmtPtr Parser::parseReturn() {
   expect(TokenKind::KwReturn, "return");
   auto v = parseExpression();
   expect(TokenKind::Semicolon, ";");
-  return std::make_unique<ReturnStmt>(std::move(v));
+  return noteStmt(arena->create<ReturnStmt>(v));
 }
 
 StmtPtr Parser::parseIf() {
@@ -98,15 +141,15 @@ StmtPtr Parser::parseIf() {
   expect(TokenKind::LBrace, "{");
   auto thenStmts = parseBlock();
   expect(TokenKind::RBrace, "}");
-  std::vector<StmtPtr> elseStmts;
+  StmtList elseStmts;
   if (match(TokenKind::KwElse)) {
     expect(TokenKind::LBrace, "{");
     elseStmts = parseBlock();
     expect(TokenKind::RBrace, "}");
   }
-  auto s = std::make_unique<IfStmt>();
-  s->cond = std::move(cond); s->thenStmts = std::move(thenStmts); s->elseStmts = std::move(elseStmts);
-  return s;
+  auto *s = arena->create<IfStmt>();
+  s->cond = cond; s->thenStmts = std::move(thenStmts); s->elseStmts = std::move(elseStmts);
+  return noteStmt(s);
 }
 
 StmtPtr Parser::parseWhile() {
@@ -117,141 +160,188 @@ StmtPtr Parser::parseWhile() {
   expect(TokenKind::LBrace, "{");
   auto body = parseBlock();
   expect(TokenKind::RBrace, "}");
-  auto s = std::make_unique<WhileStmt>();
-  s->cond = std::move(cond); s->body = std::move(body);
-  return s;
+  auto *s = arena->create<WhileStmt>();
+  s->cond = cond; s->body = std::move(body);
+  return noteStmt(s);
 }
 
 StmtPtr Parser::parseVarDecl() {
   expect(TokenKind::KwInt, "int");
   Token nameTok = consume();
-  if (nameTok.kind != TokenKind::Identifier) throw std::runtime_error("Expected variable name");
+  if (nameTok.kind != TokenKind::Identifier) errorHere("Expected variable name");
   ExprPtr init;
   if (match(TokenKind::Assign)) {
     init = parseExpression();
   }
   expect(TokenKind::Semicolon, ";");
-  return std::make_unique<VarDeclStmt>(nameTok.lexeme, std::move(init));
+  return noteStmt(arena->create<VarDeclStmt>(nameTok.symbol, init));
 }
 
 StmtPtr Parser::parseExprStmt() {
   auto e = parseExpression();
   expect(TokenKind::Semicolon, ";");
-  return std::make_unique<ExprStmt>(std::move(e));
+  return noteStmt(arena->create<ExprStmt>(e));
 }
 
 ExprPtr Parser::parseExpression() { return parseAssignment(); }
 
 ExprPtr Parser::parseAssignment() {
-  auto lhs = parseLogicalOr();
+  auto lhs = parseBinary();
   if (peek().kind == TokenKind::Assign) {
     consume();
-    if (auto v = dynamic_cast<VariableExpr*>(lhs.get())) {
+    if (lhs->kind == ExprKind::Variable) {
+      auto *v = static_cast<VariableExpr *>(lhs);
       auto rhs = parseAssignment();
-      return std::make_unique<AssignExpr>(v->name, std::move(rhs));
+      return noteExpr(arena->create<AssignExpr>(v->name, rhs));
     } else {
-      throw std::runtime_error("Invalid assignment target");
+      errorHere("Invalid assignment target");
     }
   }
   return lhs;
 }
 
-static ExprPtr makeBinary(const std::string &op, ExprPtr lhs, ExprPtr rhs) {
-  return std::make_unique<BinaryExpr>(op, std::move(lhs), std::move(rhs));
-}
-
-ExprPtr Parser::parseLogicalOr() {
-  auto e = parseLogicalAnd();
-  while (peek().kind == TokenKind::OrOr) { consume(); e = makeBinary("||", std::move(e), parseLogicalAnd()); }
-  return e;
-}
-
-ExprPtr Parser::parseLogicalAnd() {
-  auto e = parseEquality();
-  while (peek().kind == TokenKind::AndAnd) { consume(); e = makeBinary("&&", std::move(e), parseEquality()); }
-  return e;
-}
-
-ExprPtr Parser::parseEquality() {
-  auto e = parseRelational();
-  while (peek().kind == TokenKind::Eq || peek().kind == TokenKind::Ne) {
-    Token op = consume();
-    e = makeBinary(op.lexeme, std::move(e), parseRelational());
+// Binding power per binary operator token; 0 marks everything else. One
+// table drives the whole expression grammar below assignment.
+static int binaryPrecedence(TokenKind kind) {
+  switch (kind) {
+    case TokenKind::OrOr: return 1;
+    case TokenKind::AndAnd: return 2;
+    case TokenKind::Pipe: return 3;
+    case TokenKind::Caret: return 4;
+    case TokenKind::Amp: return 5;
+    case TokenKind::Eq:
+    case TokenKind::Ne: return 6;
+    case TokenKind::Lt:
+    case TokenKind::Le:
+    case TokenKind::Gt:
+    case TokenKind::Ge: return 7;
+    case TokenKind::Shl:
+    case TokenKind::Shr: return 8;
+    case TokenKind::Plus:
+    case TokenKind::Minus: return 9;
+    case TokenKind::Star:
+    case TokenKind::Slash:
+    case TokenKind::Percent: return 10;
+    default: return 0;
   }
-  return e;
 }
 
-ExprPtr Parser::parseRelational() {
-  auto e = parseAdditive();
-  while (peek().kind == TokenKind::Lt || peek().kind == TokenKind::Le || peek().kind == TokenKind::Gt || peek().kind == TokenKind::Ge) {
-    Token op = consume();
-    e = makeBinary(op.lexeme, std::move(e), parseAdditive());
+static BinOp binOpForToken(TokenKind kind) {
+  switch (kind) {
+    case TokenKind::Plus: return BinOp::Add;
+    case TokenKind::Minus: return BinOp::Sub;
+    case TokenKind::Star: return BinOp::Mul;
+    case TokenKind::Slash: return BinOp::Div;
+    case TokenKind::Percent: return BinOp::Rem;
+    case TokenKind::Eq: return BinOp::Eq;
+    case TokenKind::Ne: return BinOp::Ne;
+    case TokenKind::Lt: return BinOp::Lt;
+    case TokenKind::Le: return BinOp::Le;
+    case TokenKind::Gt: return BinOp::Gt;
+    case TokenKind::Ge: return BinOp::Ge;
+    case TokenKind::AndAnd: return BinOp::LogicalAnd;
+    case TokenKind::OrOr: return BinOp::LogicalOr;
+    case TokenKind::Amp: return BinOp::BitAnd;
+    case TokenKind::Pipe: return BinOp::BitOr;
+    case TokenKind::Caret: return BinOp::BitXor;
+    case TokenKind::Shl: return BinOp::Shl;
+    case TokenKind::Shr: return BinOp::Shr;
+    default: throw std::runtime_error("Not a binary operator token");
   }
-  return e;
 }
 
-ExprPtr Parser::parseAdditive() {
-  auto e = parseMultiplicative();
-  while (peek().kind == TokenKind::Plus || peek().kind == TokenKind::Minus) {
-    Token op = consume();
-    e = makeBinary(op.lexeme, std::move(e), parseMultiplicative());
-  }
-  return e;
-}
+// Table-driven binary expression parsing with explicit operand/operator
+// stacks: one call frame no matter how many thousands of operators deep
+// the input is, and no eight-level call cascade per operand.
+ExprPtr Parser::parseBinary() {
+  // The work stacks are members (capacity reuse), so operate above a base
+  // watermark: parsePrimary can re-enter here through parentheses.
+  const std::size_t operandBase = operandStack.size();
+  const std::size_t operatorBase = operatorStack.size();
+  operandStack.push_back(parseUnary());
 
-ExprPtr Parser::parseMultiplicative() {
-  auto e = parseUnary();
-  while (peek().kind == TokenKind::Star || peek().kind == TokenKind::Slash || peek().kind == TokenKind::Percent) {
-    Token op = consume();
-    e = makeBinary(op.lexeme, std::move(e), parseUnary());
+  auto reduce = [&] {
+    PendingOp op = operatorStack.back();
+    operatorStack.pop_back();
+    ExprPtr rhs = operandStack.back(); operandStack.pop_back();
+    ExprPtr lhs = operandStack.back(); operandStack.pop_back();
+    operandStack.push_back(noteExpr(arena->create<BinaryExpr>(op.op, lhs, rhs)));
+  };
+
+  for (;;) {
+    int prec = binaryPrecedence(peek().kind);
+    if (prec == 0) break;
+    // All binary operators are left-associative: reduce anything of equal
+    // or higher binding power before shifting.
+    while (operatorStack.size() > operatorBase && operatorStack.back().precedence >= prec)
+      reduce();
+    operatorStack.push_back(PendingOp{binOpForToken(peek().kind), prec});
+    consume();
+    operandStack.push_back(parseUnary());
   }
-  return e;
+  while (operatorStack.size() > operatorBase) reduce();
+  ExprPtr result = operandStack.back();
+  operandStack.pop_back();
+  return result;
 }
 
 ExprPtr Parser::parseUnary() {
-  if (peek().kind == TokenKind::Minus || peek().kind == TokenKind::Not || peek().kind == TokenKind::Plus) {
+  // Collect the prefix run iteratively, then wrap the operand inside-out.
+  // Same watermark discipline as parseBinary: parsePrimary re-enters.
+  const std::size_t base = unaryRun.size();
+  while (peek().kind == TokenKind::Minus || peek().kind == TokenKind::Not ||
+         peek().kind == TokenKind::Plus) {
     Token op = consume();
-    return std::make_unique<UnaryExpr>(op.lexeme, parseUnary());
+    unaryRun.push_back(op.kind == TokenKind::Minus ? UnOp::Neg
+                       : op.kind == TokenKind::Plus ? UnOp::Plus
+                                                    : UnOp::Not);
   }
-  return parsePrimary();
+  ExprPtr e = parsePrimary();
+  for (std::size_t i = unaryRun.size(); i > base; --i)
+    e = noteExpr(arena->create<UnaryExpr>(unaryRun[i - 1], e));
+  unaryRun.resize(base);
+  return e;
 }
 
 ExprPtr Parser::parsePrimary() {
   Token t = consume();
   switch (t.kind) {
-    case TokenKind::Number: return std::make_unique<NumberExpr>(t.intValue);
+    case TokenKind::Number: return noteExpr(arena->create<NumberExpr>(t.intValue));
     case TokenKind::Identifier: {
       if (match(TokenKind::LParen)) {
         auto args = parseArgList();
         expect(TokenKind::RParen, ")");
-        return std::make_unique<CallExpr>(t.lexeme, std::move(args));
+        return noteExpr(arena->create<CallExpr>(t.symbol, std::move(args)));
       }
-      return std::make_unique<VariableExpr>(t.lexeme);
+      return noteExpr(arena->create<VariableExpr>(t.symbol));
     }
     case TokenKind::LParen: {
+      if (parenDepth >= kMaxParenDepth) errorAt(t, "Expression nested too deeply");
+      ++parenDepth;
       auto e = parseExpression();
+      --parenDepth;
       expect(TokenKind::RParen, ")");
       return e;
     }
-    default: throw std::runtime_error("Unexpected token in primary");
+    default: errorAt(t, "Unexpected token in primary");
   }
 }
 
-std::vector<FunctionParam> Parser::parseParamList() {
-  std::vector<FunctionParam> params;
+ParamList Parser::parseParamList() {
+  ParamList params;
   if (peek().kind == TokenKind::RParen) return params;
   while (true) {
     expect(TokenKind::KwInt, "int");
     Token nameTok = consume();
-    if (nameTok.kind != TokenKind::Identifier) throw std::runtime_error("Expected parameter name");
-    params.push_back(FunctionParam{nameTok.lexeme});
+    if (nameTok.kind != TokenKind::Identifier) errorHere("Expected parameter name");
+    params.push_back(FunctionParam{nameTok.symbol});
     if (!match(TokenKind::Comma)) break;
   }
   return params;
 }
 
-std::vector<ExprPtr> Parser::parseArgList() {
-  std::vector<ExprPtr> args;
+ExprList Parser::parseArgList() {
+  ExprList args;
   if (peek().kind == TokenKind::RParen) return args;
   while (true) {
     args.push_back(parseExpression());
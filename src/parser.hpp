@@ -1,29 +1,66 @@
 #pragma once
 
 #include "ast.hpp"
+#include "diag.hpp"
 #include "lexer.hpp"
+#include "stats.hpp"
 #include <optional>
+#include <vector>
 
 class Parser {
 public:
-  explicit Parser(Lexer lexer);
+  // With a diagnostic engine attached the parser records errors and
+  // resynchronizes (at ';'/'}' inside bodies, at the next declaration at
+  // top level) instead of throwing on the first problem.
+  explicit Parser(Lexer lexer, CompileStats *stats = nullptr, DiagnosticEngine *diags = nullptr);
+  explicit Parser(std::vector<Token> tokens, CompileStats *stats = nullptr,
+                  DiagnosticEngine *diags = nullptr);
 
   std::unique_ptr<TranslationUnit> parseTranslationUnit();
 
+  // Parse into an existing (reset) unit so a pooled arena is reused.
+  void parseInto(TranslationUnit &tu);
+
+  // Recover the token buffer for pooling once parsing is done.
+  std::vector<Token> takeTokens() { return std::move(tokens); }
+
 private:
-  Lexer lexer;
-  Token lookahead;
-  bool hasLookahead{false};
+  // The whole source is pre-lexed into one contiguous array; peek/consume
+  // index into it instead of interleaving with the scanner.
+  std::vector<Token> tokens;
+  std::size_t pos{0};
+
+  // Never null (defaults to the shared discard sink), so node counting is
+  // an unconditional increment.
+  CompileStats *stats;
+
+  DiagnosticEngine *diags{nullptr};
+
+  // Thrown to unwind to the nearest recovery point after an error has been
+  // recorded; never escapes the parser.
+  struct RecoveryUnwind {};
+
+  [[noreturn]] void errorHere(const std::string &message);
+  [[noreturn]] void errorAt(const Token &token, const std::string &message);
+  void synchronizeStatement();
+  void synchronizeTopLevel();
+
+  ExprPtr noteExpr(ExprPtr e) { stats->noteExpr(e->kind); return e; }
+  StmtPtr noteStmt(StmtPtr s) { stats->noteStmt(s->kind); return s; }
 
   const Token &peek();
   Token consume();
   bool match(TokenKind kind);
   void expect(TokenKind kind, const char *what);
 
+  // Arena of the TranslationUnit currently being built; all nodes the
+  // parse* helpers create are allocated here.
+  Arena *arena{nullptr};
+
   // Grammar helpers
-  std::unique_ptr<ExternDecl> parseExtern();
-  std::unique_ptr<Function> parseFunction();
-  std::vector<StmtPtr> parseBlock();
+  ExternDecl *parseExtern();
+  Function *parseFunction();
+  StmtList parseBlock();
 
   StmtPtr parseStatement();
   StmtPtr parseReturn();
@@ -32,18 +69,31 @@ private:
   StmtPtr parseVarDecl();
   StmtPtr parseExprStmt();
 
-  // Expressions with precedence
+  // Expressions: assignment on top of a single table-driven
+  // precedence-climbing loop (see binaryPrecedence in parser.cpp).
   ExprPtr parseExpression();
   ExprPtr parseAssignment();
-  ExprPtr parseLogicalOr();
-  ExprPtr parseLogicalAnd();
-  ExprPtr parseEquality();
-  ExprPtr parseRelational();
-  ExprPtr parseAdditive();
-  ExprPtr parseMultiplicative();
+  ExprPtr parseBinary();
   ExprPtr parseUnary();
   ExprPtr parsePrimary();
 
-  std::vector<FunctionParam> parseParamList();
-  std::vector<ExprPtr> parseArgList();
+  // Work stacks for parseBinary/parseUnary, kept as members so repeated
+  // expressions reuse their capacity.
+  struct PendingOp {
+    BinOp op;
+    int precedence;
+  };
+  std::vector<ExprPtr> operandStack;
+  std::vector<PendingOp> operatorStack;
+  std::vector<UnOp> unaryRun;
+
+  // Parenthesized operands are the one place expression parsing still
+  // recurses (each paren re-enters through parseAssignment), so nesting is
+  // bounded with a diagnostic instead of a stack overflow. 256 matches
+  // clang's default bracket depth.
+  static constexpr unsigned kMaxParenDepth = 256;
+  unsigned parenDepth{0};
+
+  ParamList parseParamList();
+  ExprList parseArgList();
 };
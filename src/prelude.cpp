@@ -0,0 +1,133 @@
+#include "prelude.hpp"
+
+#include "cache.hpp"
+#include "diag.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "source_buffer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[4] = {'C', 'C', 'L', 'P'};
+constexpr std::uint32_t kVersion = 2; // v2: SHA-1 digest string instead of u64
+
+void writeU32(std::ofstream &out, std::uint32_t v) {
+  out.write(reinterpret_cast<const char *>(&v), sizeof v);
+}
+void writeString(std::ofstream &out, const std::string &s) {
+  writeU32(out, static_cast<std::uint32_t>(s.size()));
+  out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+bool readU32(std::ifstream &in, std::uint32_t &v) {
+  return static_cast<bool>(in.read(reinterpret_cast<char *>(&v), sizeof v));
+}
+bool readString(std::ifstream &in, std::string &s) {
+  std::uint32_t len;
+  if (!readU32(in, len) || len > (1u << 20)) return false;
+  s.resize(len);
+  return static_cast<bool>(in.read(s.data(), len));
+}
+
+} // namespace
+
+PreludeCache PreludeCache::load(const std::string &path) {
+  SourceBuffer source = SourceBuffer::open(path);
+  std::string hash = CompileCache::key(source.view(), "prelude1");
+  std::string snapshotPath = path + ".pch";
+
+  PreludeCache cache;
+  cache.contentHash = hash;
+
+  // Fast path: replay a fresh snapshot.
+  {
+    std::ifstream in(snapshotPath, std::ios::binary);
+    char magic[4];
+    std::uint32_t version, count;
+    std::string storedHash;
+    if (in.read(magic, 4) && std::equal(magic, magic + 4, kMagic) && readU32(in, version) &&
+        version == kVersion && readString(in, storedHash) && storedHash == hash &&
+        readU32(in, count)) {
+      cache.externs.reserve(count);
+      bool ok = true;
+      for (std::uint32_t i = 0; ok && i < count; ++i) {
+        ExternSig sig;
+        std::uint32_t paramCount;
+        ok = readString(in, sig.name) && readU32(in, paramCount);
+        for (std::uint32_t pi = 0; ok && pi < paramCount; ++pi) {
+          sig.params.emplace_back();
+          ok = readString(in, sig.params.back());
+        }
+        if (ok) cache.externs.push_back(std::move(sig));
+      }
+      if (ok) return cache;
+      cache.externs.clear(); // corrupt snapshot; fall through and rebuild
+    }
+  }
+
+  // Slow path: parse the prelude (externs only) and snapshot it.
+  Interner interner;
+  DiagnosticEngine diag;
+  Lexer lex(source.view(), interner, &diag);
+  Parser parser(lex, nullptr, &diag);
+  auto tu = parser.parseTranslationUnit();
+  if (diag.hasErrors()) {
+    diag.report(std::cerr, path, source.view());
+    throw std::runtime_error("invalid prelude: " + path);
+  }
+  if (!tu->functions.empty())
+    throw std::runtime_error("prelude may only contain extern declarations: " + path);
+
+  for (const ExternDecl *e : tu->externs) {
+    ExternSig sig;
+    sig.name = std::string(interner.spelling(e->name));
+    for (const FunctionParam &p : e->params)
+      sig.params.push_back(std::string(interner.spelling(p.name)));
+    cache.externs.push_back(std::move(sig));
+  }
+
+  // Atomic snapshot write, same discipline as the compilation cache.
+  std::string tmpPath = snapshotPath + ".tmp." + std::to_string(::getpid());
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (out) {
+      out.write(kMagic, 4);
+      writeU32(out, kVersion);
+      writeString(out, hash);
+      writeU32(out, static_cast<std::uint32_t>(cache.externs.size()));
+      for (const ExternSig &sig : cache.externs) {
+        writeString(out, sig.name);
+        writeU32(out, static_cast<std::uint32_t>(sig.params.size()));
+        for (const std::string &p : sig.params) writeString(out, p);
+      }
+      out.flush();
+      if (!out) {
+        std::remove(tmpPath.c_str());
+        return cache; // snapshot is an optimization; the parse succeeded
+      }
+    } else {
+      return cache;
+    }
+  }
+  if (std::rename(tmpPath.c_str(), snapshotPath.c_str()) != 0) std::remove(tmpPath.c_str());
+
+  return cache;
+}
+
+void PreludeCache::inject(TranslationUnit &tu, Interner &interner) const {
+  for (const ExternSig &sig : externs) {
+    auto *e = tu.arena.create<ExternDecl>();
+    e->name = interner.intern(sig.name);
+    for (const std::string &p : sig.params) e->params.push_back(FunctionParam{interner.intern(p)});
+    tu.externs.push_back(e);
+  }
+}
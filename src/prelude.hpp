@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ast.hpp"
+#include "interner.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Shared-prelude cache: our generated sources all start with the same few
+// hundred `extern int ...;` declarations. The prelude file is parsed once
+// and snapshotted to <path>.pch in a simple binary format keyed by a hash
+// of the prelude bytes; subsequent compilations (and subsequent ccl runs)
+// replay the snapshot -- a handful of interner inserts per file instead of
+// re-lexing and re-parsing the block every time.
+class PreludeCache {
+public:
+  struct ExternSig {
+    std::string name;
+    std::vector<std::string> params;
+  };
+
+  // Loads <path>.pch when its recorded hash matches the prelude's current
+  // bytes; otherwise parses the prelude and rewrites the snapshot.
+  // Throws std::runtime_error if the prelude can't be read or parsed.
+  static PreludeCache load(const std::string &path);
+
+  // Interns the cached names into this compilation's interner and appends
+  // arena-allocated ExternDecls to the unit.
+  void inject(TranslationUnit &tu, Interner &interner) const;
+
+  std::size_t size() const { return externs.size(); }
+
+  // Hex digest of the prelude bytes; folded into the compilation cache
+  // fingerprint so a prelude edit invalidates cached outputs.
+  const std::string &hash() const { return contentHash; }
+
+private:
+  std::vector<ExternSig> externs;
+  std::string contentHash;
+};
@@ -0,0 +1,85 @@
+#include "source_buffer.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CCL_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceBuffer SourceBuffer::open(const std::string &path) {
+  SourceBuffer buf;
+
+  if (path == "-") {
+    std::stringstream ss; ss << std::cin.rdbuf();
+    buf.owned = ss.str();
+    buf.data = buf.owned.data();
+    buf.size = buf.owned.size();
+    return buf;
+  }
+
+#if CCL_HAVE_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("could not open file: " + path);
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      ::close(fd);
+      buf.data = static_cast<const char *>(p);
+      buf.size = static_cast<std::size_t>(st.st_size);
+      buf.mapped = true;
+      return buf;
+    }
+    // mmap refused (e.g. special filesystem); fall through to a read.
+  }
+
+  // Pipes, empty files, or an mmap failure: drain the fd we already hold.
+  // Reopening by path would lose buffered FIFO data.
+  char chunk[1 << 16];
+  ssize_t n;
+  while ((n = ::read(fd, chunk, sizeof chunk)) > 0) buf.owned.append(chunk, static_cast<std::size_t>(n));
+  ::close(fd);
+  if (n < 0) throw std::runtime_error("could not read file: " + path);
+#else
+  std::ifstream in(path, std::ios::binary);
+  if (!in) throw std::runtime_error("could not open file: " + path);
+  std::stringstream ss; ss << in.rdbuf();
+  buf.owned = ss.str();
+#endif
+  buf.data = buf.owned.data();
+  buf.size = buf.owned.size();
+  return buf;
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer &&other) noexcept
+    : data(other.data), size(other.size), mapped(other.mapped), owned(std::move(other.owned)) {
+  if (!mapped) data = owned.data();
+  other.data = nullptr; other.size = 0; other.mapped = false;
+}
+
+SourceBuffer &SourceBuffer::operator=(SourceBuffer &&other) noexcept {
+  if (this != &other) {
+#if CCL_HAVE_MMAP
+    if (mapped && data) munmap(const_cast<char *>(data), size);
+#endif
+    data = other.data; size = other.size; mapped = other.mapped; owned = std::move(other.owned);
+    if (!mapped) data = owned.data();
+    other.data = nullptr; other.size = 0; other.mapped = false;
+  }
+  return *this;
+}
+
+SourceBuffer::~SourceBuffer() {
+#if CCL_HAVE_MMAP
+  if (mapped && data) munmap(const_cast<char *>(data), size);
+#endif
+}
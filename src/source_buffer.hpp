@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Read-only view of an input file, memory-mapped when the platform and the
+// file allow it so the lexer reads pages on demand with zero up-front copies.
+// Falls back to a plain buffered read for pipes/stdin ("-") and on platforms
+// without mmap. The buffer must outlive every Token and AST name sliced
+// from it (see Lexer).
+class SourceBuffer {
+public:
+  // Throws std::runtime_error if the file cannot be opened or read.
+  static SourceBuffer open(const std::string &path);
+
+  SourceBuffer(SourceBuffer &&other) noexcept;
+  SourceBuffer &operator=(SourceBuffer &&other) noexcept;
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+  ~SourceBuffer();
+
+  std::string_view view() const { return {data, size}; }
+
+private:
+  SourceBuffer() = default;
+
+  const char *data{nullptr};
+  std::size_t size{0};
+  bool mapped{false};
+  std::string owned; // fallback storage when not mmap'd
+};
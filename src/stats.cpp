@@ -0,0 +1,54 @@
+#include "stats.hpp"
+
+namespace {
+
+constexpr const char *exprNames[] = {"number", "variable", "binary", "call", "unary", "assign"};
+constexpr const char *stmtNames[] = {"return", "expr", "vardecl", "if", "while"};
+
+} // namespace
+
+void CompileStats::report(std::ostream &os) const {
+  os << "===-------------------------------------------===\n";
+  os << " ccl compile-time report\n";
+  os << "===-------------------------------------------===\n";
+  char buf[128];
+  auto line = [&](const char *name, double wall, double cpu) {
+    std::snprintf(buf, sizeof buf, "  %-10s %9.3f ms wall  %9.3f ms cpu\n", name, wall * 1e3,
+                  cpu * 1e3);
+    os << buf;
+  };
+  line("lex", lexWall, lexCpu);
+  line("parse", parseWall, parseCpu);
+  line("fold", foldWall, foldCpu);
+  line("codegen", codegenWall, codegenCpu);
+
+  os << "  tokens lexed: " << tokensLexed << "\n";
+  std::uint64_t totalNodes = 0;
+  for (auto n : exprNodes) totalNodes += n;
+  for (auto n : stmtNodes) totalNodes += n;
+  os << "  ast nodes: " << totalNodes << "\n";
+  for (std::size_t i = 0; i < exprNodes.size(); ++i)
+    if (exprNodes[i]) os << "    expr." << exprNames[i] << ": " << exprNodes[i] << "\n";
+  for (std::size_t i = 0; i < stmtNodes.size(); ++i)
+    if (stmtNodes[i]) os << "    stmt." << stmtNames[i] << ": " << stmtNodes[i] << "\n";
+  os << "  allocas created: " << allocasCreated << "\n";
+  os << "  instructions emitted: " << instructionsEmitted << "\n";
+}
+
+void CompileStats::reportJson(std::ostream &os) const {
+  os << "{\"phases\":{";
+  os << "\"lex\":{\"wall_s\":" << lexWall << ",\"cpu_s\":" << lexCpu << "},";
+  os << "\"parse\":{\"wall_s\":" << parseWall << ",\"cpu_s\":" << parseCpu << "},";
+  os << "\"fold\":{\"wall_s\":" << foldWall << ",\"cpu_s\":" << foldCpu << "},";
+  os << "\"codegen\":{\"wall_s\":" << codegenWall << ",\"cpu_s\":" << codegenCpu << "}";
+  os << "},\"tokens\":" << tokensLexed << ",\"nodes\":{";
+  bool first = true;
+  for (std::size_t i = 0; i < exprNodes.size(); ++i) {
+    if (!first) os << ",";
+    os << "\"expr." << exprNames[i] << "\":" << exprNodes[i];
+    first = false;
+  }
+  for (std::size_t i = 0; i < stmtNodes.size(); ++i)
+    os << ",\"stmt." << stmtNames[i] << "\":" << stmtNodes[i];
+  os << "},\"allocas\":" << allocasCreated << ",\"instructions\":" << instructionsEmitted << "}\n";
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ast.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+
+// Hot-path compile statistics: phase wall/CPU timers plus counters for
+// tokens lexed, AST nodes by kind, allocas created and LLVM instructions
+// emitted. Producers increment through a pointer that defaults to a shared
+// dummy instance, so the counting is a plain unconditional add -- cheap
+// enough to leave enabled in production.
+struct CompileStats {
+  double lexWall{0}, parseWall{0}, foldWall{0}, codegenWall{0};
+  double lexCpu{0}, parseCpu{0}, foldCpu{0}, codegenCpu{0};
+
+  std::uint64_t tokensLexed{0};
+  std::array<std::uint64_t, 6> exprNodes{}; // indexed by ExprKind
+  std::array<std::uint64_t, 5> stmtNodes{}; // indexed by StmtKind
+  std::uint64_t allocasCreated{0};
+  std::uint64_t instructionsEmitted{0};
+
+  void noteExpr(ExprKind k) { ++exprNodes[static_cast<std::size_t>(k)]; }
+  void noteStmt(StmtKind k) { ++stmtNodes[static_cast<std::size_t>(k)]; }
+
+  // Sink for callers that don't care; increments land here and are never
+  // read, avoiding a null check on every node. Thread-local so parallel
+  // codegen workers don't race on it.
+  static CompileStats &discard() {
+    static thread_local CompileStats sink;
+    return sink;
+  }
+
+  // -ftime-report style text.
+  void report(std::ostream &os) const;
+
+  // One-line JSON object for build telemetry.
+  void reportJson(std::ostream &os) const;
+};
+
+// Accumulates wall and CPU time for one phase over its lifetime.
+class PhaseTimer {
+public:
+  PhaseTimer(double &wall, double &cpu)
+      : wall(wall), cpu(cpu), wallStart(std::chrono::steady_clock::now()),
+        cpuStart(std::clock()) {}
+  ~PhaseTimer() {
+    wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    cpu += static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+  }
+  PhaseTimer(const PhaseTimer &) = delete;
+  PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+  double &wall;
+  double &cpu;
+  std::chrono::steady_clock::time_point wallStart;
+  std::clock_t cpuStart;
+};
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "interner.hpp"
+
 #include <cstdint>
-#include <string>
+#include <string_view>
 
 enum class TokenKind {
   Eof,
@@ -33,13 +35,21 @@ enum class TokenKind {
   Ge,
   AndAnd,
   OrOr,
-  Not
+  Not,
+  Amp,
+  Pipe,
+  Caret,
+  Shl,
+  Shr
 };
 
 struct Token {
   TokenKind kind{TokenKind::Eof};
-  std::string lexeme{};
+  // Slice of the source buffer (kept alive by the driver); never owning.
+  std::string_view lexeme{};
   std::int64_t intValue{0};
-  std::size_t line{1};
-  std::size_t column{1};
+  Symbol symbol{0}; // interned id, Identifier tokens only
+  // Byte offset of the token start in the source buffer. Line/column are
+  // derived on demand through LineMap -- only the error path wants them.
+  std::size_t offset{0};
 };